@@ -15,10 +15,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "edge_list.h"
+#include "csr.h"
+#include "shortest_paths.h"
+#include "reorder.h"
+#include "snapshot.h"
+#include "pagerank.h"
+#include "batch.h"
+
+#define BFS_ALPHA 14 // go bottom-up once the frontier's edges exceed the unexplored edges / BFS_ALPHA
+#define BFS_BETA 24  // go back to top-down once the frontier holds fewer than numnodes / BFS_BETA vertices
 
 typedef struct node
 {
     int data;          // value of the node
+    int weight;        // weight of the edge to this node, 1 for edges added without a weight
     struct node *next; // pointer to the next node, as adjacent nodes are linked together in a linked list
 } Node;
 typedef Node *NodePtr;
@@ -27,10 +43,14 @@ typedef struct graph
 {
     int numnodes;      // number of nodes
     NodePtr *adjlists; // lsit of NodePtrs, each NodePtr points to a linked list of adjacent nodes
+    int *degrees;      // length of each adjacency list, kept so traversals can estimate their work up front
+    NodePtr slab;      // nodes allocated in one block by load_graph, NULL if every node was malloc'd on its own
+    long slabsize;     // number of nodes in the slab
 } Graph;
 typedef Graph *GraphPtr;
 
 void add_edge(GraphPtr g, int from_node, int to_node);    // add an edge between two nodes
+void add_weighted_edge(GraphPtr g, int from_node, int to_node, int weight); // add an edge with a weight between two nodes
 NodePtr create_node(int val);                             // create a node
 GraphPtr create_graph(int numnodes);                      // create a graph
 void print_graph(GraphPtr g);                             // print the graph
@@ -38,9 +58,72 @@ void destroy_graph(GraphPtr *g);                          // destroy the graph
 void remove_edge(GraphPtr g, int from_node, int to_node); // remove an edge between two nodes
 void add_vertex(GraphPtr *g);                             // add a vertex
 bool has_edge(GraphPtr g, int from_node, int to_node);    // check if there is an edge between two nodes
+void bfs(GraphPtr g, int source, int *dist, int *parent); // direction-optimizing breadth first search from source
+int connected_components(GraphPtr g, int *labels, int numthreads); // label every vertex with its component, returns the number of components
+int cc_benchmark(int numnodes, long numedges, int numthreads);      // time connected_components on a random graph, 1 thread vs numthreads
+GraphPtr load_graph(const char *path, int numthreads);              // build a graph from a text or binary edge list file
+int load_benchmark(const char *path, int numthreads);               // time load_graph on a file
+CsrPtr graph_to_csr(GraphPtr g);                                    // contiguous copy of the graph for read-only kernels
+int sssp_benchmark(int numnodes, long numedges, int numthreads);    // time dijkstra vs delta_stepping on a random weighted graph
+void permute_graph(GraphPtr *g, const int *old_to_new);             // rebuild the graph with every vertex v renamed to old_to_new[v]
+int reorder_benchmark(int side);                                    // time BFS on a shuffled grid graph before and after reordering
+int save_graph(GraphPtr g, const char *path);                       // write the graph as a memory-mappable snapshot (see snapshot.h)
+int snapshot_benchmark(const char *edges, const char *path, int numthreads); // time building a graph from a file vs opening its snapshot
+int pagerank_benchmark(int numnodes, long numedges, int numthreads); // time every pagerank iteration on a random graph, 1 thread vs numthreads
+void add_edges(GraphPtr g, const int *pairs, long count, int numthreads);    // add a batch of edges, pairs[2 * i] - pairs[2 * i + 1]
+void remove_edges(GraphPtr g, const int *pairs, long count, int numthreads); // remove a batch of edges
+int batch_benchmark(int numnodes, long numedges, long batchsize, int numthreads); // time a batch of updates, one call per edge vs add_edges / remove_edges
 
-int main(void)
+#ifndef GRAPH_NO_MAIN // bench.c includes this file and brings its own main
+int main(int argc, char **argv)
 {
+    // USAGE: ./adj_list cc <numnodes> <numedges> <numthreads>
+    // example: gcc -O2 -pthread adj_list.c -o adj_list; ./adj_list cc 1000000 4000000 4
+    if (argc == 5 && strcmp(argv[1], "cc") == 0)
+        return cc_benchmark(atoi(argv[2]), atol(argv[3]), atoi(argv[4]));
+
+    // USAGE: ./adj_list load <file> <numthreads>
+    // example: ./adj_list load edges.txt 4
+    if (argc == 4 && strcmp(argv[1], "load") == 0)
+        return load_benchmark(argv[2], atoi(argv[3]));
+
+    // USAGE: ./adj_list sssp <numnodes> <numedges> <numthreads>
+    // example: gcc -O2 -pthread adj_list.c -o adj_list; ./adj_list sssp 1000000 10000000 4
+    if (argc == 5 && strcmp(argv[1], "sssp") == 0)
+        return sssp_benchmark(atoi(argv[2]), atol(argv[3]), atoi(argv[4]));
+
+    // USAGE: ./adj_list reorder <grid side>
+    // example: gcc -O2 -pthread adj_list.c -o adj_list; ./adj_list reorder 1000
+    if (argc == 3 && strcmp(argv[1], "reorder") == 0)
+        return reorder_benchmark(atoi(argv[2]));
+
+    // USAGE: ./adj_list snapshot <edge list file> <snapshot file> <numthreads>
+    // example: ./adj_list snapshot edges.txt edges.snap 4
+    if (argc == 5 && strcmp(argv[1], "snapshot") == 0)
+        return snapshot_benchmark(argv[2], argv[3], atoi(argv[4]));
+
+    // USAGE: ./adj_list pagerank <numnodes> <numedges> <numthreads>
+    // example: gcc -O2 -pthread adj_list.c -o adj_list; ./adj_list pagerank 1000000 10000000 4
+    if (argc == 5 && strcmp(argv[1], "pagerank") == 0)
+        return pagerank_benchmark(atoi(argv[2]), atol(argv[3]), atoi(argv[4]));
+
+    // USAGE: ./adj_list batch <numnodes> <numedges> <batch size> <numthreads>
+    // example: gcc -O2 -pthread adj_list.c -o adj_list; ./adj_list batch 1000000 10000000 1000000 4
+    if (argc == 6 && strcmp(argv[1], "batch") == 0)
+        return batch_benchmark(atoi(argv[2]), atol(argv[3]), atol(argv[4]), atoi(argv[5]));
+
+    // USAGE: ./adj_list tobin <text file> <binary file>
+    // example: ./adj_list tobin edges.txt edges.bin
+    if (argc == 4 && strcmp(argv[1], "tobin") == 0)
+    {
+        EdgeListPtr el = read_edge_list(argv[2], 1);
+        if (el == NULL)
+            return 1;
+        int status = write_binary_edge_list(argv[3], el);
+        destroy_edge_list(el);
+        return status;
+    }
+
     GraphPtr g = create_graph(8); // create a graph with 8 nodes
 
     // adding edges between nodes
@@ -66,9 +149,48 @@ int main(void)
 
     print_graph(g); // print the graph
 
+    // breadth first search from vertex 1
+    int *dist = malloc(sizeof(int) * g->numnodes);
+    int *parent = malloc(sizeof(int) * g->numnodes);
+    bfs(g, 1, dist, parent);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d | distance %d | parent %d\n", i, dist[i], parent[i]);
+    free(dist);
+    free(parent);
+
+    // connected components, each vertex is labelled with the smallest vertex in its component
+    int *labels = malloc(sizeof(int) * g->numnodes);
+    printf("Number of connected components: %d\n", connected_components(g, labels, 2));
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d | component %d\n", i, labels[i]);
+    free(labels);
+
+    // weighted shortest paths from vertex 1, the 1 -> 3 edge is made expensive so the path through 2 wins
+    add_weighted_edge(g, 2, 8, 4);
+    remove_edge(g, 1, 3);
+    add_weighted_edge(g, 1, 3, 10);
+    long *weighted_dist = malloc(sizeof(long) * g->numnodes);
+    int *weighted_parent = malloc(sizeof(int) * g->numnodes);
+    CsrPtr c = graph_to_csr(g); // the shortest path engine runs on a contiguous copy of the lists
+    dijkstra(c, 1, weighted_dist, weighted_parent);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d | weighted distance %ld | parent %d\n", i, weighted_dist[i], weighted_parent[i]);
+    free(weighted_dist);
+    free(weighted_parent);
+
+    // relabel the vertices in reverse Cuthill-McKee order, old_to_new says where every vertex went
+    int *old_to_new = vertex_order(c, ORDER_RCM);
+    permute_graph(&g, old_to_new);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d is now vertex %d\n", i, old_to_new[i]);
+    print_graph(g);
+    free(old_to_new);
+    destroy_csr(c);
+
     destroy_graph(&g); // destroy the graph, free the memory
     return 0;
 }
+#endif
 
 GraphPtr create_graph(int numnodes)
 {
@@ -79,6 +201,9 @@ GraphPtr create_graph(int numnodes)
     GraphPtr nu = malloc(sizeof(Graph));                  // allocate memory for the graph
     nu->numnodes = numnodes;                              // initialize the number of nodes
     nu->adjlists = calloc(sizeof(NodePtr), nu->numnodes); // allocate memory for the adjacency list
+    nu->degrees = calloc(sizeof(int), nu->numnodes);      // every vertex starts with no edges
+    nu->slab = NULL;                                      // no bulk allocated nodes yet
+    nu->slabsize = 0;
     return nu;                                            // return the graph
 }
 
@@ -90,6 +215,7 @@ NodePtr create_node(int val)
     */
     NodePtr nu = malloc(sizeof(Node)); // allocate memory for the node
     nu->data = val;                    // initialize the value of the node
+    nu->weight = 1;                    // unweighted edges count as weight 1
     nu->next = NULL;                   // initialize the next node to NULL, as we don't know what the next node is yet
     return nu;                         // return the node
 }
@@ -100,17 +226,30 @@ void add_edge(GraphPtr g, int from_node, int to_node)
         Time Complexity: O(1), as there is no looping involved.
         Space Complexity: O(n), as you're creating a node and adding a pointer to the next node.
     */
+    add_weighted_edge(g, from_node, to_node, 1); // an unweighted edge is an edge of weight 1
+}
+
+void add_weighted_edge(GraphPtr g, int from_node, int to_node, int weight)
+{
+    /*
+        Time Complexity: O(1), as there is no looping involved.
+        Space Complexity: O(n), as you're creating a node and adding a pointer to the next node. The weight fits in the node's padding, so a weighted node is no bigger than an unweighted one.
+    */
 
     NodePtr nu = create_node(to_node); // allocate space for the new node
+    nu->weight = weight;               // both directions of the edge carry the same weight
 
     // create an edge from the from_node to the new node
     nu->next = g->adjlists[from_node]; // set the next node of the new node to the original first node in the index list
     g->adjlists[from_node] = nu;       // set the first node of the index to the newly created node
+    g->degrees[from_node]++;           // one more edge in from_node's list
 
     // create an edge from the to_node to the from_node
     nu = create_node(from_node);     // allocate space for the new node
+    nu->weight = weight;
     nu->next = g->adjlists[to_node]; // set the next node of the new node to the original first node in the index list
     g->adjlists[to_node] = nu;       // set the first node of the index to the newly created node
+    g->degrees[to_node]++;           // one more edge in to_node's list
 }
 
 void print_graph(GraphPtr g)
@@ -134,6 +273,16 @@ void print_graph(GraphPtr g)
     }
 }
 
+static void free_node(GraphPtr g, NodePtr nu)
+{
+    // nodes that live in the slab are freed all at once by destroy_graph
+    uintptr_t addr = (uintptr_t)nu;
+    uintptr_t slab = (uintptr_t)g->slab;
+    if (addr >= slab && addr < slab + g->slabsize * sizeof(Node))
+        return;
+    free(nu);
+}
+
 void destroy_graph(GraphPtr *g)
 {
     /*
@@ -148,10 +297,12 @@ void destroy_graph(GraphPtr *g)
         {
             temp = nu;     // set the temporary node pointer to the current node
             nu = nu->next; // set the node pointer to the next node
-            free(temp);    // free the memory of the temporary node
+            free_node(*g, temp); // free the memory of the temporary node
         }
     }
     free((*g)->adjlists); // free the memory of the adjacency list
+    free((*g)->degrees);  // free the degree counts
+    free((*g)->slab);     // free the bulk allocated nodes, if any
     free(*g);             // free the memory of the graph
 }
 
@@ -172,7 +323,8 @@ void remove_edge(GraphPtr g, int from_node, int to_node)
                 g->adjlists[from_node] = nu->next; // set the first node of the index to the next node
             else
                 prev->next = nu->next; // set the next node of the previous node to the next node
-            free(nu);                  // free the memory of the node
+            free_node(g, nu);          // free the memory of the node
+            g->degrees[from_node]--;   // one less edge in from_node's list
             break;                     // break out of the loop
         }
         prev = nu;     // set the previous node to the current node
@@ -190,7 +342,8 @@ void remove_edge(GraphPtr g, int from_node, int to_node)
                 g->adjlists[to_node] = nu->next;
             else
                 prev->next = nu->next;
-            free(nu);
+            free_node(g, nu);
+            g->degrees[to_node]--;
             break;
         }
         prev = nu;
@@ -212,7 +365,10 @@ void add_vertex(GraphPtr *g)
     }
     free((*g)->adjlists);          // free the memory of the old list
     (*g)->adjlists = new_adjlists; // set the old list to the new list
-    (*g)->numnodes++;              // increment the number of nodes
+
+    (*g)->degrees = realloc((*g)->degrees, sizeof(int) * ((*g)->numnodes + 1)); // make room for the new vertex's degree
+    (*g)->degrees[(*g)->numnodes] = 0;                                           // the new vertex has no edges yet
+    (*g)->numnodes++;                                                            // increment the number of nodes
 }
 
 bool has_edge(GraphPtr g, int from_node, int to_node)
@@ -229,4 +385,772 @@ bool has_edge(GraphPtr g, int from_node, int to_node)
         nu = nu->next;
     }
     return false; // edge doesn't exist
-}
\ No newline at end of file
+}
+
+static inline bool bitmap_test(const uint64_t *bits, int i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1; // check the bit of vertex i
+}
+
+static inline void bitmap_set(uint64_t *bits, int i)
+{
+    bits[i >> 6] |= (uint64_t)1 << (i & 63); // set the bit of vertex i
+}
+
+void bfs(GraphPtr g, int source, int *dist, int *parent)
+{
+    /*
+        Time Complexity: O(n + m). Top-down steps walk every edge of the frontier, while bottom-up steps let each unvisited vertex stop at the first neighbor found in the frontier. On low-diameter graphs the big middle levels run bottom-up, so far fewer than m edges are examined.
+        Space Complexity: O(n), as the current and next frontiers are bitmaps of n bits each.
+    */
+    int words = (g->numnodes + 63) / 64;                  // number of 64-bit words in a frontier bitmap
+    uint64_t *frontier = calloc(words, sizeof(uint64_t)); // vertices discovered in the previous level
+    uint64_t *next = calloc(words, sizeof(uint64_t));     // vertices discovered in the current level
+
+    long unexplored_edges = 0; // edges incident to vertices that have not been visited yet
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        dist[i] = -1;   // -1 marks an unreached vertex
+        parent[i] = -1; // unreached vertices have no parent
+        unexplored_edges += g->degrees[i];
+    }
+
+    dist[source] = 0;           // the source is at distance 0
+    parent[source] = source;    // the source is its own parent
+    bitmap_set(frontier, source);
+
+    long frontier_edges = g->degrees[source]; // edges a top-down step would have to examine
+    unexplored_edges -= frontier_edges;
+    int frontier_size = 1;   // number of vertices in the frontier
+    bool bottom_up = false;  // current search direction
+
+    for (int level = 1; frontier_size > 0; level++)
+    {
+        // pick the direction for this level based on how big the frontier is
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_ALPHA)
+            bottom_up = true; // frontier is large, cheaper for unvisited vertices to look for a parent
+        else if (bottom_up && frontier_size < g->numnodes / BFS_BETA)
+            bottom_up = false; // frontier shrank again, cheaper to expand it directly
+
+        long next_edges = 0; // edges incident to the next frontier
+        int next_size = 0;   // vertices in the next frontier
+
+        if (bottom_up)
+        {
+            for (int v = 0; v < g->numnodes; v++)
+            {
+                if (dist[v] != -1)
+                    continue; // already visited
+                for (NodePtr nu = g->adjlists[v]; nu != NULL; nu = nu->next)
+                {
+                    if (bitmap_test(frontier, nu->data))
+                    {
+                        // found a parent in the frontier, no need to look at v's other edges
+                        dist[v] = level;
+                        parent[v] = nu->data;
+                        bitmap_set(next, v);
+                        next_size++;
+                        next_edges += g->degrees[v];
+                        break;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t bits = frontier[w];
+                while (bits != 0)
+                {
+                    int u = w * 64 + __builtin_ctzll(bits); // lowest vertex left in this word
+                    bits &= bits - 1;                       // clear that bit
+                    for (NodePtr nu = g->adjlists[u]; nu != NULL; nu = nu->next)
+                    {
+                        int v = nu->data;
+                        if (dist[v] == -1)
+                        {
+                            // first time we see v, u becomes its parent
+                            dist[v] = level;
+                            parent[v] = u;
+                            bitmap_set(next, v);
+                            next_size++;
+                            next_edges += g->degrees[v];
+                        }
+                    }
+                }
+            }
+        }
+
+        unexplored_edges -= next_edges; // the next frontier's edges are no longer unexplored
+        frontier_edges = next_edges;
+        frontier_size = next_size;
+
+        uint64_t *tmp = frontier; // the next frontier becomes the current one
+        frontier = next;
+        next = tmp;
+        memset(next, 0, words * sizeof(uint64_t)); // clear the old frontier so it can be reused
+    }
+
+    free(frontier);
+    free(next);
+}
+
+typedef struct cc_task
+{
+    GraphPtr g;                 // graph being labelled
+    atomic_int *comp;           // union-find parent of every vertex, shared by all workers
+    int *labels;                // output label of every vertex
+    int lo, hi;                 // range of vertices [lo, hi) owned by this worker
+    pthread_barrier_t *barrier; // workers wait here until every edge has been linked
+} CCTask;
+
+static int uf_find(atomic_int *comp, int v)
+{
+    // follow parents up to the root, halving the path on the way with CAS so concurrent finds never lose a link
+    while (true)
+    {
+        int p = atomic_load_explicit(&comp[v], memory_order_relaxed);
+        if (p == v)
+            return v; // v is a root
+        int gp = atomic_load_explicit(&comp[p], memory_order_relaxed);
+        if (p != gp)
+            atomic_compare_exchange_weak_explicit(&comp[v], &p, gp, memory_order_relaxed, memory_order_relaxed); // point v at its grandparent
+        v = gp;
+    }
+}
+
+static void uf_union(atomic_int *comp, int u, int v)
+{
+    // always hang the larger root under the smaller one, so parents only ever decrease and no cycle can form
+    while (true)
+    {
+        u = uf_find(comp, u);
+        v = uf_find(comp, v);
+        if (u == v)
+            return; // already in the same component
+        if (u < v)
+        {
+            int tmp = u; // make u the larger root
+            u = v;
+            v = tmp;
+        }
+        int expected = u;
+        if (atomic_compare_exchange_strong_explicit(&comp[u], &expected, v, memory_order_relaxed, memory_order_relaxed))
+            return; // linked u under v
+        // another worker linked u first, retry from the new roots
+    }
+}
+
+static void *cc_worker(void *arg)
+{
+    CCTask *t = arg;
+
+    // link both ends of every edge in this worker's range, each undirected edge is seen from its smaller endpoint only
+    for (int u = t->lo; u < t->hi; u++)
+        for (NodePtr nu = t->g->adjlists[u]; nu != NULL; nu = nu->next)
+            if (nu->data > u)
+                uf_union(t->comp, u, nu->data);
+
+    pthread_barrier_wait(t->barrier); // every edge must be linked before roots are final
+
+    for (int v = t->lo; v < t->hi; v++)
+        t->labels[v] = uf_find(t->comp, v); // the root is the smallest vertex of the component
+    return NULL;
+}
+
+int connected_components(GraphPtr g, int *labels, int numthreads)
+{
+    /*
+        Time Complexity: O(m * a(n) / p) for p threads, as the edges are split between the threads and every union-find operation is lock-free with path halving (a is the inverse Ackermann function).
+        Space Complexity: O(n), for the shared union-find parents.
+    */
+    if (numthreads < 1)
+        numthreads = 1;
+
+    atomic_int *comp = malloc(sizeof(atomic_int) * g->numnodes); // union-find parents
+    for (int i = 0; i < g->numnodes; i++)
+        atomic_init(&comp[i], i); // every vertex starts as its own component
+
+    long total = 0; // total number of list nodes, used to give every thread the same amount of edges
+    for (int i = 0; i < g->numnodes; i++)
+        total += g->degrees[i];
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    CCTask *tasks = malloc(sizeof(CCTask) * numthreads);
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, numthreads);
+
+    int v = 0;     // first vertex not handed out yet
+    long seen = 0; // edges handed out so far
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].g = g;
+        tasks[t].comp = comp;
+        tasks[t].labels = labels;
+        tasks[t].barrier = &barrier;
+        tasks[t].lo = v;
+        long target = total * (t + 1) / numthreads; // this thread ends once this many edges have been handed out
+        while (v < g->numnodes && (seen < target || t == numthreads - 1))
+            seen += g->degrees[v++];
+        tasks[t].hi = v;
+    }
+
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, cc_worker, &tasks[t]);
+    cc_worker(&tasks[0]); // the calling thread does its own share
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    int count = 0; // each component has exactly one root
+    for (int i = 0; i < g->numnodes; i++)
+        if (labels[i] == i)
+            count++;
+
+    pthread_barrier_destroy(&barrier);
+    free(tasks);
+    free(threads);
+    free(comp);
+    return count;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int cc_benchmark(int numnodes, long numedges, int numthreads)
+{
+    /*
+        Time Complexity: O(n + m), dominated by building the random graph.
+        Space Complexity: O(n + m), for the graph and two label arrays.
+    */
+    GraphPtr g = create_graph(numnodes);
+    srand(42); // same graph on every run
+    for (long i = 0; i < numedges; i++)
+        add_edge(g, (int)(((long)rand() * RAND_MAX + rand()) % numnodes), (int)(((long)rand() * RAND_MAX + rand()) % numnodes));
+
+    int *baseline = malloc(sizeof(int) * numnodes);
+    int *labels = malloc(sizeof(int) * numnodes);
+
+    double start = now_seconds();
+    int count = connected_components(g, baseline, 1); // single-threaded baseline
+    double single = now_seconds() - start;
+
+    start = now_seconds();
+    int parallel_count = connected_components(g, labels, numthreads);
+    double parallel = now_seconds() - start;
+
+    bool same = parallel_count == count && memcmp(baseline, labels, sizeof(int) * numnodes) == 0; // labels are canonical, so both runs must agree exactly
+    printf("vertices %d | edges %ld | components %d\n", numnodes, numedges, count);
+    printf("1 thread: %.3f s | %d threads: %.3f s | speedup %.2fx | labels match: %s\n", single, numthreads, parallel, single / parallel, same ? "true" : "false");
+
+    free(baseline);
+    free(labels);
+    destroy_graph(&g);
+    return same ? 0 : 1;
+}
+
+GraphPtr load_graph(const char *path, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p + n + m). The file is parsed by p threads (see edge_list.h), then the degrees are counted and every list is filled in place.
+        Space Complexity: O(n + m). All 2m list nodes come from a single allocation instead of one malloc per edge.
+    */
+    EdgeListPtr el = read_edge_list(path, numthreads);
+    if (el == NULL)
+        return NULL; // couldn't read the file
+
+    GraphPtr g = create_graph(el->numnodes);
+
+    // count the degrees first, so every vertex gets a contiguous run of nodes in the slab
+    for (long i = 0; i < el->numedges; i++)
+    {
+        g->degrees[el->from[i]]++;
+        g->degrees[el->to[i]]++;
+    }
+
+    long *fill = malloc(sizeof(long) * (g->numnodes + 1)); // next free slot in each vertex's run
+    fill[0] = 0;
+    for (int i = 0; i < g->numnodes; i++)
+        fill[i + 1] = fill[i] + g->degrees[i];
+
+    g->slabsize = fill[g->numnodes];
+    g->slab = malloc(sizeof(Node) * (g->slabsize > 0 ? g->slabsize : 1));
+
+    // chain each run into a list, the last node of a run ends the list
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        g->adjlists[i] = g->degrees[i] > 0 ? &g->slab[fill[i]] : NULL;
+        for (long j = fill[i]; j < fill[i + 1]; j++)
+            g->slab[j].next = (j + 1 < fill[i + 1]) ? &g->slab[j + 1] : NULL;
+    }
+
+    // place both directions of every edge, same as add_edge does
+    for (long i = 0; i < el->numedges; i++)
+    {
+        int weight = el->weights != NULL ? el->weights[i] : 1; // files without weights are unweighted
+        NodePtr forward = &g->slab[fill[el->from[i]]++];
+        NodePtr backward = &g->slab[fill[el->to[i]]++];
+        forward->data = el->to[i];
+        forward->weight = weight;
+        backward->data = el->from[i];
+        backward->weight = weight;
+    }
+
+    free(fill);
+    destroy_edge_list(el);
+    return g;
+}
+
+int load_benchmark(const char *path, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p + n + m), same as load_graph.
+        Space Complexity: O(n + m), same as load_graph.
+    */
+    double start = now_seconds();
+    GraphPtr g = load_graph(path, numthreads);
+    double elapsed = now_seconds() - start;
+    if (g == NULL)
+    {
+        printf("Could not read %s\n", path);
+        return 1;
+    }
+
+    printf("vertices %d | edges %ld | %d threads | %.3f s\n", g->numnodes, g->slabsize / 2, numthreads, elapsed);
+    if (g->numnodes <= 16)
+        print_graph(g); // small graphs are printed so the result can be checked by eye
+
+    destroy_graph(&g);
+    return 0;
+}
+
+CsrPtr graph_to_csr(GraphPtr g)
+{
+    /*
+        Time Complexity: O(n + m), as every list is walked once. The degrees are already known, so the offsets are computed before any list is touched.
+        Space Complexity: O(n + m), for the CSR arrays (see csr.h). Each list keeps its order, so the neighbors of a vertex come out in the same order as in print_graph.
+    */
+    long total = 0;
+    for (int i = 0; i < g->numnodes; i++)
+        total += g->degrees[i];
+
+    CsrPtr c = create_csr(g->numnodes, total, true);
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        long e = c->offsets[i];
+        for (NodePtr nu = g->adjlists[i]; nu != NULL; nu = nu->next, e++)
+        {
+            c->targets[e] = nu->data; // neighbors of i, back to back
+            c->weights[e] = nu->weight;
+        }
+        c->offsets[i + 1] = e;
+    }
+    return c;
+}
+
+int sssp_benchmark(int numnodes, long numedges, int numthreads)
+{
+    /*
+        Time Complexity: O(n * log(C) + m), dominated by building the graph and running both searches.
+        Space Complexity: O(n + m), for the graph and the distance arrays.
+    */
+    GraphPtr g = create_graph(numnodes);
+    srand(42); // same graph on every run
+    for (long i = 0; i < numedges; i++)
+    {
+        int u = (int)(((long)rand() * RAND_MAX + rand()) % numnodes);
+        int v = (int)(((long)rand() * RAND_MAX + rand()) % numnodes);
+        add_weighted_edge(g, u, v, 1 + rand() % 100); // weights between 1 and 100
+    }
+
+    long *expected = malloc(sizeof(long) * numnodes);
+    long *dist = malloc(sizeof(long) * numnodes);
+    int *parent = malloc(sizeof(int) * numnodes);
+
+    double start = now_seconds();
+    CsrPtr c = graph_to_csr(g); // built once, then shared by every query
+    double build = now_seconds() - start;
+
+    start = now_seconds();
+    dijkstra(c, 0, expected, parent);
+    double sequential = now_seconds() - start;
+
+    start = now_seconds();
+    delta_stepping(c, 0, dist, 0, numthreads);
+    double parallel = now_seconds() - start;
+
+    bool same = memcmp(expected, dist, sizeof(long) * numnodes) == 0;
+    printf("vertices %d | edges %ld | csr built in %.3f s\n", numnodes, numedges, build);
+    printf("dijkstra: %.3f s | delta stepping with %d threads: %.3f s | distances match: %s\n", sequential, numthreads, parallel, same ? "true" : "false");
+
+    free(expected);
+    free(dist);
+    free(parent);
+    destroy_csr(c);
+    destroy_graph(&g);
+    return same ? 0 : 1;
+}
+
+void permute_graph(GraphPtr *g, const int *old_to_new)
+{
+    /*
+        Time Complexity: O(n + m), as every list is walked once.
+        Space Complexity: O(n + m). The new graph is built like load_graph does: the nodes of all the lists come from one slab, laid out in the new vertex order,
+        so vertices with close ids also have their neighbors close together in memory. Weights and the order of each list are kept.
+    */
+    GraphPtr old = *g;
+    GraphPtr nu = create_graph(old->numnodes);
+
+    for (int v = 0; v < old->numnodes; v++)
+        nu->degrees[old_to_new[v]] = old->degrees[v]; // a vertex keeps its degree under its new name
+
+    long *fill = malloc(sizeof(long) * (nu->numnodes + 1)); // first slot of each vertex's run in the slab
+    fill[0] = 0;
+    for (int i = 0; i < nu->numnodes; i++)
+        fill[i + 1] = fill[i] + nu->degrees[i];
+
+    nu->slabsize = fill[nu->numnodes];
+    nu->slab = malloc(sizeof(Node) * (nu->slabsize > 0 ? nu->slabsize : 1));
+
+    for (int v = 0; v < old->numnodes; v++)
+    {
+        int target = old_to_new[v];
+        long j = fill[target];
+        nu->adjlists[target] = old->degrees[v] > 0 ? &nu->slab[j] : NULL;
+        for (NodePtr node = old->adjlists[v]; node != NULL; node = node->next, j++)
+        {
+            nu->slab[j].data = old_to_new[node->data]; // rename the neighbor too
+            nu->slab[j].weight = node->weight;
+            nu->slab[j].next = (j + 1 < fill[target + 1]) ? &nu->slab[j + 1] : NULL;
+        }
+    }
+
+    free(fill);
+    destroy_graph(g);
+    *g = nu;
+}
+
+static GraphPtr shuffled_grid(int side)
+{
+    // side x side grid where the vertices get random ids, so neighbors on the grid are far apart in memory
+    int n = side * side;
+    int *shuffle = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++)
+        shuffle[i] = i;
+    srand(42); // same labels on every call
+    for (int i = n - 1; i > 0; i--)
+    {
+        int j = (int)(((long)rand() * RAND_MAX + rand()) % (i + 1));
+        int tmp = shuffle[i];
+        shuffle[i] = shuffle[j];
+        shuffle[j] = tmp;
+    }
+
+    GraphPtr g = create_graph(n);
+    for (int r = 0; r < side; r++)
+    {
+        for (int c = 0; c < side; c++)
+        {
+            if (c + 1 < side)
+                add_edge(g, shuffle[r * side + c], shuffle[r * side + c + 1]); // right neighbor
+            if (r + 1 < side)
+                add_edge(g, shuffle[r * side + c], shuffle[(r + 1) * side + c]); // neighbor below
+        }
+    }
+    free(shuffle);
+    return g;
+}
+
+int reorder_benchmark(int side)
+{
+    /*
+        Time Complexity: O(n log n + m) per ordering, where n = side^2, dominated by computing the RCM order.
+        Space Complexity: O(n + m), for the graph and the order.
+    */
+    int n = side * side;
+    const char *names[] = {"original", "rcm", "degree", "bfs"};
+    VertexOrder orders[] = {ORDER_BFS, ORDER_RCM, ORDER_DEGREE, ORDER_BFS}; // the first entry is not used, "original" keeps the shuffled ids
+    int *dist = malloc(sizeof(int) * n);
+    int *parent = malloc(sizeof(int) * n);
+    printf("grid %d x %d | vertices %d\n", side, side, n);
+
+    for (int k = 0; k < 4; k++)
+    {
+        GraphPtr g = shuffled_grid(side);
+        int *old_to_new;
+        if (k == 0)
+        {
+            old_to_new = malloc(sizeof(int) * n);
+            for (int i = 0; i < n; i++)
+                old_to_new[i] = i; // keep the ids
+        }
+        else
+        {
+            CsrPtr c = graph_to_csr(g);
+            old_to_new = vertex_order(c, orders[k]);
+            destroy_csr(c);
+        }
+        permute_graph(&g, old_to_new); // every run gets compact lists, so only the labels differ between the runs
+
+        // the same 5 searches in every run: same start vertices, under their new names
+        double start = now_seconds();
+        for (int s = 0; s < 5; s++)
+            bfs(g, old_to_new[(long)s * n / 5], dist, parent);
+        printf("%-8s | 5 bfs: %.3f s\n", names[k], now_seconds() - start);
+
+        free(old_to_new);
+        destroy_graph(&g);
+    }
+
+    free(dist);
+    free(parent);
+    return 0;
+}
+
+int save_graph(GraphPtr g, const char *path)
+{
+    /*
+        Time Complexity: O(n + m log d), as the graph is copied to a CSR view and every neighbor list is sorted while it is written.
+        Space Complexity: O(n + m), for the CSR view.
+    */
+    CsrPtr c = graph_to_csr(g);
+    int status = save_snapshot(c, path);
+    destroy_csr(c);
+    return status;
+}
+
+int snapshot_benchmark(const char *edges, const char *path, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p + n + m log d) to build the graph and save it, opening the snapshot is O(1).
+        Space Complexity: O(n + m), for the graph. The snapshot itself lives in the page cache.
+    */
+    double start = now_seconds();
+    GraphPtr g = load_graph(edges, numthreads);
+    double load_time = now_seconds() - start;
+    if (g == NULL || save_graph(g, path) != 0)
+    {
+        printf("Could not read %s or write %s\n", edges, path);
+        if (g != NULL)
+            destroy_graph(&g);
+        return 1;
+    }
+
+    start = now_seconds();
+    SnapshotPtr s = open_snapshot(path);
+    double open_time = now_seconds() - start;
+    if (s == NULL)
+    {
+        printf("Could not open snapshot %s\n", path);
+        destroy_graph(&g);
+        return 1;
+    }
+
+    // every edge of the graph must be found in the snapshot, and the degrees must agree
+    start = now_seconds();
+    bool match = s->numnodes == g->numnodes;
+    for (int v = 0; match && v < g->numnodes; v++)
+    {
+        match = snapshot_degree(s, v) == g->degrees[v];
+        for (NodePtr nu = g->adjlists[v]; match && nu != NULL; nu = nu->next)
+            match = snapshot_has_edge(s, v, nu->data);
+    }
+    double query_time = now_seconds() - start;
+
+    printf("vertices %d | edges %ld\n", g->numnodes, s->numedges / 2);
+    printf("build from edge list: %.3f s | open snapshot: %.6f s | check every edge in place: %.3f s | snapshot matches: %s\n",
+           load_time, open_time, query_time, match ? "true" : "false");
+
+    close_snapshot(s);
+    destroy_graph(&g);
+    return match ? 0 : 1;
+}
+
+int pagerank_benchmark(int numnodes, long numedges, int numthreads)
+{
+    /*
+        Time Complexity: O(iterations * (n + m)), plus building the random graph.
+        Space Complexity: O(n + m), for the graph, its CSR view and the ranks.
+    */
+    GraphPtr g = create_graph(numnodes);
+    srand(42); // same graph on every run
+    for (long i = 0; i < numedges; i++)
+        add_edge(g, (int)(((long)rand() * RAND_MAX + rand()) % numnodes), (int)(((long)rand() * RAND_MAX + rand()) % numnodes));
+    CsrPtr c = graph_to_csr(g);
+    destroy_graph(&g); // pagerank only needs the CSR view
+
+    const int maxiters = 100;
+    double *baseline = malloc(sizeof(double) * numnodes);
+    double *rank = malloc(sizeof(double) * numnodes);
+    double *seconds = malloc(sizeof(double) * maxiters);
+    printf("vertices %d | edges %ld\n", numnodes, numedges);
+
+    int single_iters = pagerank(c, baseline, NULL, 0.85, 1e-6, maxiters, 1, seconds);
+    double single = 0;
+    for (int i = 0; i < single_iters; i++)
+        single += seconds[i];
+
+    int iters = pagerank(c, rank, NULL, 0.85, 1e-6, maxiters, numthreads, seconds);
+    double parallel = 0;
+    for (int i = 0; i < iters; i++)
+    {
+        printf("iteration %d | %.4f s\n", i + 1, seconds[i]);
+        parallel += seconds[i];
+    }
+
+    double diff = 0;
+    int top = 0;
+    for (int v = 0; v < numnodes; v++)
+    {
+        diff += baseline[v] > rank[v] ? baseline[v] - rank[v] : rank[v] - baseline[v];
+        if (rank[v] > rank[top])
+            top = v;
+    }
+    bool same = single_iters == iters && diff < 1e-9; // each vertex is summed in the same order with any number of threads
+    printf("%d iterations | 1 thread: %.4f s per iteration | %d threads: %.4f s per iteration | speedup %.2fx | ranks match: %s\n",
+           iters, single / single_iters, numthreads, parallel / iters, single / parallel, same ? "true" : "false");
+    printf("highest rank: vertex %d (%.3g)\n", top, rank[top]);
+
+    // personalized from vertex 0: every jump goes back to it
+    double *jump = calloc(numnodes, sizeof(double));
+    jump[0] = 1;
+    iters = pagerank(c, rank, jump, 0.85, 1e-6, maxiters, numthreads, NULL);
+    printf("personalized from vertex 0: %d iterations | rank of vertex 0: %.3g\n", iters, rank[0]);
+
+    free(jump);
+    free(baseline);
+    free(rank);
+    free(seconds);
+    destroy_csr(c);
+    return same ? 0 : 1;
+}
+
+static long batch_find(const int *targets, long count, int v)
+{
+    // index of v in the sorted targets of a batch group, -1 if it isn't there
+    long lo = 0, hi = count;
+    while (lo < hi)
+    {
+        long mid = lo + (hi - lo) / 2;
+        if (targets[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < count && targets[lo] == v ? lo : -1;
+}
+
+static void batch_add(void *context, int thread, int source, const int *targets, long count)
+{
+    // the whole group is linked in front of source's list, like add_edge does one edge at a time
+    (void)thread;
+    GraphPtr g = context;
+    for (long i = 0; i < count; i++)
+    {
+        int copies = targets[i] == source ? 2 : 1; // add_edge stores a self loop twice in the same list, so does the batch
+        for (int k = 0; k < copies; k++)
+        {
+            NodePtr nu = create_node(targets[i]);
+            nu->next = g->adjlists[source];
+            g->adjlists[source] = nu;
+            g->degrees[source]++;
+        }
+    }
+}
+
+static void batch_remove(void *context, int thread, int source, const int *targets, long count)
+{
+    // one pass over source's list unlinks every node whose neighbor is in the batch
+    (void)thread;
+    GraphPtr g = context;
+    NodePtr nu = g->adjlists[source];
+    NodePtr prev = NULL;
+    while (nu != NULL)
+    {
+        NodePtr next = nu->next;
+        if (batch_find(targets, count, nu->data) >= 0)
+        {
+            if (prev == NULL)
+                g->adjlists[source] = next;
+            else
+                prev->next = next;
+            free_node(g, nu);
+            g->degrees[source]--;
+        }
+        else
+            prev = nu;
+        nu = next;
+    }
+}
+
+void add_edges(GraphPtr g, const int *pairs, long count, int numthreads)
+{
+    /*
+        Time Complexity: O(m / p) for a batch of m edges split over p threads (see batch.h), as every vertex's new edges are linked in by the thread that owns it.
+        An edge that appears twice in the batch is only added once. Like add_edge, the graph itself is not searched, so adding an edge that is already there stores it again.
+        Space Complexity: O(m), for sorting the batch, plus one node per new edge direction.
+    */
+    apply_edge_batch(pairs, count, g->numnodes, true, numthreads, batch_add, g);
+}
+
+void remove_edges(GraphPtr g, const int *pairs, long count, int numthreads)
+{
+    /*
+        Time Complexity: O(m + d log k) per touched vertex, where remove_edge would walk the list once per removed edge. Every copy of a removed edge goes.
+        Space Complexity: O(m), for sorting the batch.
+    */
+    apply_edge_batch(pairs, count, g->numnodes, true, numthreads, batch_remove, g);
+}
+
+int batch_benchmark(int numnodes, long numedges, long batchsize, int numthreads)
+{
+    /*
+        Time Complexity: O(batchsize * d) for the single edge removals, O(n + m + batchsize) for everything else.
+        Space Complexity: O(n + m), for two copies of the graph.
+    */
+    int *pairs = malloc(sizeof(int) * 2 * (numedges > batchsize ? numedges : batchsize));
+    srand(42); // same graph on every run
+    for (long i = 0; i < 2 * numedges; i++)
+        pairs[i] = (int)(((long)rand() * RAND_MAX + rand()) % numnodes);
+    GraphPtr single = create_graph(numnodes);
+    GraphPtr batched = create_graph(numnodes);
+    add_edges(single, pairs, numedges, numthreads);
+    add_edges(batched, pairs, numedges, numthreads);
+
+    for (long i = 0; i < 2 * batchsize; i++)
+        pairs[i] = (int)(((long)rand() * RAND_MAX + rand()) % numnodes); // the update batch, new edges
+    printf("vertices %d | edges %ld | batch %ld | %d threads\n", numnodes, numedges, batchsize, numthreads);
+
+    double start = now_seconds();
+    for (long i = 0; i < batchsize; i++)
+        add_edge(single, pairs[2 * i], pairs[2 * i + 1]);
+    double single_add = now_seconds() - start;
+    start = now_seconds();
+    add_edges(batched, pairs, batchsize, numthreads);
+    double batch_add_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (long i = 0; i < batchsize; i++)
+        remove_edge(single, pairs[2 * i], pairs[2 * i + 1]);
+    double single_remove = now_seconds() - start;
+    start = now_seconds();
+    remove_edges(batched, pairs, batchsize, numthreads);
+    double batch_remove_time = now_seconds() - start;
+
+    // none of the batch's edges may be left
+    bool ok = true;
+    for (long i = 0; i < batchsize && ok; i++)
+        ok = !has_edge(batched, pairs[2 * i], pairs[2 * i + 1]);
+    printf("add:    one call per edge %.3f s | add_edges %.3f s | speedup %.2fx\n", single_add, batch_add_time, single_add / batch_add_time);
+    printf("remove: one call per edge %.3f s | remove_edges %.3f s | speedup %.2fx\n", single_remove, batch_remove_time, single_remove / batch_remove_time);
+    printf("batch edges gone after remove_edges: %s\n", ok ? "true" : "false");
+
+    free(pairs);
+    destroy_graph(&single);
+    destroy_graph(&batched);
+    return ok ? 0 : 1;
+}
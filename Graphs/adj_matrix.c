@@ -15,11 +15,23 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "edge_list.h"
+#include "csr.h"
+#include "shortest_paths.h"
+#include "reorder.h"
+#include "snapshot.h"
+#include "batch.h"
 
 typedef struct mygraph
 {
-    int numnodes; // number of nodes
-    bool **edges; // 2D matrix of edges
+    int numnodes;  // number of nodes
+    bool **edges;  // 2D matrix of edges
+    int **weights; // 2D matrix of edge weights, NULL until the first weighted edge is added
 } graph;
 typedef graph *GraphPtr;
 
@@ -30,9 +42,57 @@ void add_edge(GraphPtr g, int from_node, int to_node); // add an edge between tw
 void add_vertex(GraphPtr *g);                          // add a vertex
 bool has_edge(GraphPtr g, int from_node, int to_node); // check if there is an edge between two nodes
 void remove_edge(GraphPtr g, int from_node, int to_node);
-
-int main()
+void add_weighted_edge(GraphPtr g, int from_node, int to_node, int weight); // add an edge with a weight between two nodes
+int edge_weight(GraphPtr g, int from_node, int to_node);                    // weight of an edge, 1 if the graph is unweighted
+CsrPtr graph_to_csr(GraphPtr g);                                            // contiguous copy of the graph for read-only kernels
+void bfs(GraphPtr g, int source, int *dist, int *parent); // direction-optimizing breadth first search from source
+GraphPtr load_graph(const char *path, int numthreads);    // build a graph from a text or binary edge list file
+GraphPtr transitive_closure(GraphPtr g, int numthreads);  // graph with an edge from i to j whenever j can be reached from i
+long count_triangles(GraphPtr g, int numthreads);         // number of triangles, ignoring edge directions
+int dense_benchmark(int numnodes, int percent, int numthreads); // time transitive_closure and count_triangles on a random graph
+void permute_graph(GraphPtr *g, const int *old_to_new);   // rebuild the graph with every vertex v renamed to old_to_new[v]
+int save_graph(GraphPtr g, const char *path);             // write the graph as a memory-mappable snapshot (see snapshot.h)
+void add_edges(GraphPtr g, const int *pairs, long count, int numthreads);    // add a batch of edges, pairs[2 * i] -> pairs[2 * i + 1]
+void remove_edges(GraphPtr g, const int *pairs, long count, int numthreads); // remove a batch of edges
+
+#ifndef GRAPH_NO_MAIN // bench.c includes this file and brings its own main
+int main(int argc, char **argv)
 {
+    // USAGE: ./adj_matrix dense <numnodes> <edge probability in percent> <numthreads>
+    // example: gcc -O3 -march=native -pthread adj_matrix.c -o adj_matrix; ./adj_matrix dense 4000 5 4
+    if (argc == 5 && strcmp(argv[1], "dense") == 0)
+        return dense_benchmark(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+
+    // USAGE: ./adj_matrix save <edge list file> <snapshot file>
+    // example: ./adj_matrix save edges.txt edges.snap
+    if (argc == 4 && strcmp(argv[1], "save") == 0)
+    {
+        GraphPtr loaded = load_graph(argv[2], 1);
+        if (loaded == NULL)
+        {
+            printf("Could not read %s\n", argv[2]);
+            return 1;
+        }
+        int status = save_graph(loaded, argv[3]);
+        destroy_graph(loaded);
+        return status;
+    }
+
+    // USAGE: ./adj_matrix load <file> <numthreads>
+    // example: ./adj_matrix load edges.txt 4
+    if (argc == 4 && strcmp(argv[1], "load") == 0)
+    {
+        GraphPtr loaded = load_graph(argv[2], atoi(argv[3]));
+        if (loaded == NULL)
+        {
+            printf("Could not read %s\n", argv[2]);
+            return 1;
+        }
+        print_graph(loaded);
+        destroy_graph(loaded);
+        return 0;
+    }
+
     GraphPtr g = create_graph(8); // create a graph with 8 nodes
 
     // adding edges between nodes
@@ -52,8 +112,46 @@ int main()
 
     print_graph(g); // print the graph
 
+    // breadth first search from vertex 0
+    int *dist = malloc(sizeof(int) * g->numnodes);
+    int *parent = malloc(sizeof(int) * g->numnodes);
+    bfs(g, 0, dist, parent);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d | distance %d | parent %d\n", i, dist[i], parent[i]);
+    free(dist);
+    free(parent);
+
+    // weighted shortest paths from vertex 0, going through 1 is cheaper than the direct 0 -> 2 edge
+    add_weighted_edge(g, 0, 2, 10);
+    add_weighted_edge(g, 0, 1, 2);
+    add_weighted_edge(g, 1, 2, 3);
+    long *weighted_dist = malloc(sizeof(long) * g->numnodes);
+    int *weighted_parent = malloc(sizeof(int) * g->numnodes);
+    CsrPtr c = graph_to_csr(g); // the shortest path engine runs on the CSR view
+    dijkstra(c, 0, weighted_dist, weighted_parent);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d | weighted distance %ld | parent %d\n", i, weighted_dist[i], weighted_parent[i]);
+    free(weighted_dist);
+    free(weighted_parent);
+
+    // relabel the vertices in BFS order, old_to_new says where every vertex went
+    int *old_to_new = vertex_order(c, ORDER_BFS);
+    permute_graph(&g, old_to_new);
+    for (int i = 0; i < g->numnodes; i++)
+        printf("Vertex %d is now vertex %d\n", i, old_to_new[i]);
+    print_graph(g);
+    free(old_to_new);
+    destroy_csr(c);
+
+    // every vertex reachable from each vertex, and the triangles 0 1 2 and 1 2 3
+    GraphPtr closure = transitive_closure(g, 2);
+    print_graph(closure);
+    destroy_graph(closure);
+    printf("Number of triangles: %ld\n", count_triangles(g, 2));
+
     destroy_graph(g); // destroy the graph
 }
+#endif
 
 GraphPtr create_graph(int numnodes)
 {
@@ -69,6 +167,7 @@ GraphPtr create_graph(int numnodes)
 
     // initialize our object
     g->numnodes = numnodes;
+    g->weights = NULL; // unweighted until add_weighted_edge is called
     g->edges = calloc(sizeof(bool *), g->numnodes); // initialize the 2D matrix to zeros
 
     if (g->edges == NULL) // if the 2D matrix failed to allocate
@@ -110,6 +209,13 @@ void destroy_graph(GraphPtr g)
     }
 
     free(g->edges); // free the 2D matrix
+
+    if (g->weights != NULL)
+    {
+        for (int i = 0; i < g->numnodes; i++)
+            free(g->weights[i]); // free each row of weights
+        free(g->weights);
+    }
     free(g);        // free the graph
 }
 
@@ -159,6 +265,8 @@ void add_edge(GraphPtr g, int from_node, int to_node)
     }
 
     g->edges[from_node][to_node] = true; // set the edge to 1, indicating an edge exists
+    if (g->weights != NULL)
+        g->weights[from_node][to_node] = 1; // a removed weighted edge may have left its old weight here
 }
 
 bool has_edge(GraphPtr g, int from_node, int to_node)
@@ -193,6 +301,14 @@ void add_vertex(GraphPtr *gPtr)
         }
     }
 
+    if (g->weights != NULL)
+    {
+        for (int i = 0; i < g->numnodes; i++)
+            for (int j = 0; j < g->numnodes; j++)
+                if (g->edges[i][j])
+                    add_weighted_edge(nu, i, j, g->weights[i][j]); // copy the weights as well
+    }
+
     destroy_graph(g); // destroy the old graph
 
     *gPtr = nu; // set the new graph pointer
@@ -216,4 +332,546 @@ void remove_edge(GraphPtr g, int from_node, int to_node)
     }
 
     g->edges[from_node][to_node] = false; // set the edge to 0, indicating no edge exists
-}
\ No newline at end of file
+}
+
+static inline bool bitmap_test(const uint64_t *bits, int i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1; // check the bit of vertex i
+}
+
+static inline void bitmap_set(uint64_t *bits, int i)
+{
+    bits[i >> 6] |= (uint64_t)1 << (i & 63); // set the bit of vertex i
+}
+
+void bfs(GraphPtr g, int source, int *dist, int *parent)
+{
+    /*
+        Time Complexity: O(n^2) in the worst case. A top-down step reads the whole row of every frontier vertex (n cells each), while a bottom-up step lets each unvisited vertex walk the frontier bitmap and stop at the first vertex with an edge to it. Each level picks whichever of the two is estimated to read fewer cells.
+        Space Complexity: O(n), as the current and next frontiers are bitmaps of n bits each.
+    */
+    assert(g != NULL);
+    assert(source >= 0 && source < g->numnodes);
+
+    int words = (g->numnodes + 63) / 64;                  // number of 64-bit words in a frontier bitmap
+    uint64_t *frontier = calloc(words, sizeof(uint64_t)); // vertices discovered in the previous level
+    uint64_t *next = calloc(words, sizeof(uint64_t));     // vertices discovered in the current level
+
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        dist[i] = -1;   // -1 marks an unreached vertex
+        parent[i] = -1; // unreached vertices have no parent
+    }
+
+    dist[source] = 0;        // the source is at distance 0
+    parent[source] = source; // the source is its own parent
+    bitmap_set(frontier, source);
+
+    int frontier_size = 1;           // number of vertices in the frontier
+    int unvisited = g->numnodes - 1; // number of vertices not reached yet
+
+    for (int level = 1; frontier_size > 0; level++)
+    {
+        // top-down reads a full row per frontier vertex, bottom-up reads at most the frontier (plus its bitmap) per unvisited vertex
+        long top_down_cost = (long)frontier_size * g->numnodes;
+        long bottom_up_cost = (long)unvisited * (words + frontier_size);
+        int next_size = 0; // vertices in the next frontier
+
+        if (bottom_up_cost < top_down_cost)
+        {
+            for (int v = 0; v < g->numnodes; v++)
+            {
+                if (dist[v] != -1)
+                    continue; // already visited
+                for (int w = 0; w < words && dist[v] == -1; w++)
+                {
+                    uint64_t bits = frontier[w];
+                    while (bits != 0)
+                    {
+                        int u = w * 64 + __builtin_ctzll(bits); // lowest frontier vertex left in this word
+                        bits &= bits - 1;                       // clear that bit
+                        if (g->edges[u][v])
+                        {
+                            // found a parent in the frontier, no need to look any further
+                            dist[v] = level;
+                            parent[v] = u;
+                            bitmap_set(next, v);
+                            next_size++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t bits = frontier[w];
+                while (bits != 0)
+                {
+                    int u = w * 64 + __builtin_ctzll(bits); // lowest frontier vertex left in this word
+                    bits &= bits - 1;                       // clear that bit
+                    for (int v = 0; v < g->numnodes; v++)
+                    {
+                        if (g->edges[u][v] && dist[v] == -1)
+                        {
+                            // first time we see v, u becomes its parent
+                            dist[v] = level;
+                            parent[v] = u;
+                            bitmap_set(next, v);
+                            next_size++;
+                        }
+                    }
+                }
+            }
+        }
+
+        unvisited -= next_size;
+        frontier_size = next_size;
+
+        uint64_t *tmp = frontier; // the next frontier becomes the current one
+        frontier = next;
+        next = tmp;
+        memset(next, 0, words * sizeof(uint64_t)); // clear the old frontier so it can be reused
+    }
+
+    free(frontier);
+    free(next);
+}
+
+GraphPtr load_graph(const char *path, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p + n^2 + m). The file is parsed by p threads (see edge_list.h), the matrix is allocated once with its final size and every edge is a single store.
+        Space Complexity: O(n^2), for the matrix. No add_vertex calls are needed since the number of nodes is known before the matrix is created.
+    */
+    EdgeListPtr el = read_edge_list(path, numthreads);
+    if (el == NULL)
+        return NULL; // couldn't read the file
+
+    GraphPtr g = create_graph(el->numnodes);
+    if (g != NULL)
+    {
+        for (long i = 0; i < el->numedges; i++)
+        {
+            if (el->weights != NULL)
+                add_weighted_edge(g, el->from[i], el->to[i], el->weights[i]);
+            else
+                g->edges[el->from[i]][el->to[i]] = true; // same as add_edge, without the per-call checks
+        }
+    }
+
+    destroy_edge_list(el);
+    return g;
+}
+
+void add_weighted_edge(GraphPtr g, int from_node, int to_node, int weight)
+{
+    /*
+        Time Complexity: O(1), except for the first weighted edge, which allocates the weight matrix in O(n^2).
+        Space Complexity: O(n^2) for the first weighted edge, O(1) afterwards. Unweighted graphs never pay for the weight matrix.
+    */
+
+    // safety checks
+    assert(g != NULL);
+    assert(from_node >= 0 && from_node < g->numnodes);
+    assert(to_node >= 0 && to_node < g->numnodes);
+
+    if (g->weights == NULL)
+    {
+        // first weighted edge, every edge added so far had weight 1
+        g->weights = malloc(sizeof(int *) * g->numnodes);
+        for (int i = 0; i < g->numnodes; i++)
+        {
+            g->weights[i] = malloc(sizeof(int) * g->numnodes);
+            for (int j = 0; j < g->numnodes; j++)
+                g->weights[i][j] = 1;
+        }
+    }
+
+    g->edges[from_node][to_node] = true;     // the edge exists
+    g->weights[from_node][to_node] = weight; // and has this weight
+}
+
+int edge_weight(GraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(1), as you'll be returning the value of the weight.
+        Space Complexity: O(1), as no memory is allocated in this function.
+    */
+
+    // safety checks
+    assert(g != NULL);
+    assert(from_node >= 0 && from_node < g->numnodes);
+    assert(to_node >= 0 && to_node < g->numnodes);
+
+    return g->weights != NULL ? g->weights[from_node][to_node] : 1; // unweighted edges count as weight 1
+}
+
+CsrPtr graph_to_csr(GraphPtr g)
+{
+    /*
+        Time Complexity: O(n^2), as every cell of the matrix is read once (twice when counting the edges first).
+        Space Complexity: O(n + m), for the CSR arrays (see csr.h). The CSR view only stores the edges that exist, so sparse kernels don't have to scan whole rows.
+    */
+    long total = 0;
+    for (int r = 0; r < g->numnodes; r++)
+        for (int c = 0; c < g->numnodes; c++)
+            total += g->edges[r][c]; // count the edges first so the arrays are allocated once
+
+    CsrPtr csr = create_csr(g->numnodes, total, g->weights != NULL);
+    long e = 0;
+    for (int r = 0; r < g->numnodes; r++)
+    {
+        for (int c = 0; c < g->numnodes; c++)
+        {
+            if (!g->edges[r][c])
+                continue;
+            csr->targets[e] = c; // row r becomes the neighbor list of vertex r
+            if (g->weights != NULL)
+                csr->weights[e] = g->weights[r][c];
+            e++;
+        }
+        csr->offsets[r + 1] = e;
+    }
+    return csr;
+}
+
+/* The all-pairs kernels below don't work on the bool matrix directly, they first pack it into bit rows: one bit per cell, 64 cells per word.
+ * A whole row of 4096 vertices is then 64 words, so OR-ing or AND-ing two rows is 64 word operations instead of 4096 byte operations.
+ * Rows are padded to a multiple of BITROW_ALIGN bytes and the matrix is aligned the same way, so the word loops compile to full width SIMD
+ * instructions (with -O3 -march=native) without needing any platform specific intrinsics. */
+#define BITROW_ALIGN 64 // bytes, one cache line (and two AVX2 / one AVX-512 register)
+#define ROW_BLOCK 64    // rows handed to a thread at a time by count_triangles
+
+typedef struct bitmatrix
+{
+    int numnodes;   // number of rows and columns
+    long words;     // 64-bit words per row, padded
+    uint64_t *bits; // row r starts at bits + r * words
+} BitMatrix;
+
+static BitMatrix *pack_rows(GraphPtr g, bool upper_symmetric)
+{
+    // pack the bool matrix into bit rows, or with upper_symmetric, keep for each row only the neighbors with a larger index, ignoring edge directions
+    BitMatrix *m = malloc(sizeof(BitMatrix));
+    m->numnodes = g->numnodes;
+    m->words = ((g->numnodes + 511) / 512) * 8; // round up to a whole number of 64 byte lines
+    if (m->words == 0)
+        m->words = 8;
+    m->bits = aligned_alloc(BITROW_ALIGN, sizeof(uint64_t) * m->words * (g->numnodes > 0 ? g->numnodes : 1));
+    memset(m->bits, 0, sizeof(uint64_t) * m->words * (g->numnodes > 0 ? g->numnodes : 1));
+
+    for (int r = 0; r < g->numnodes; r++)
+    {
+        uint64_t *row = m->bits + r * m->words;
+        for (int c = 0; c < g->numnodes; c++)
+        {
+            bool edge = g->edges[r][c];
+            if (upper_symmetric)
+                edge = c > r && (g->edges[r][c] || g->edges[c][r]); // undirected edge r - c, stored once in the row of its smaller end
+            if (edge)
+                row[c >> 6] |= (uint64_t)1 << (c & 63);
+        }
+    }
+    return m;
+}
+
+static void destroy_bitmatrix(BitMatrix *m)
+{
+    free(m->bits);
+    free(m);
+}
+
+static inline void bitrow_or(uint64_t *restrict dst, const uint64_t *restrict src, long words)
+{
+    dst = __builtin_assume_aligned(dst, BITROW_ALIGN);
+    src = __builtin_assume_aligned(src, BITROW_ALIGN);
+    for (long w = 0; w < words; w++)
+        dst[w] |= src[w]; // vectorized by the compiler, words is a multiple of 8
+}
+
+static inline long bitrow_and_popcount(const uint64_t *restrict a, const uint64_t *restrict b, long words)
+{
+    a = __builtin_assume_aligned(a, BITROW_ALIGN);
+    b = __builtin_assume_aligned(b, BITROW_ALIGN);
+    long count = 0;
+    for (long w = 0; w < words; w++)
+        count += __builtin_popcountll(a[w] & b[w]); // number of columns set in both rows
+    return count;
+}
+
+typedef struct closure_task
+{
+    BitMatrix *m;               // reachability matrix being built
+    int lo, hi;                 // rows [lo, hi) owned by this thread
+    pthread_barrier_t *barrier; // threads finish step k together before anyone starts step k + 1
+} ClosureTask;
+
+static void *closure_worker(void *arg)
+{
+    ClosureTask *t = arg;
+    BitMatrix *m = t->m;
+    for (int k = 0; k < m->numnodes; k++)
+    {
+        // Warshall step k: whoever reaches k also reaches everything k reaches
+        const uint64_t *row_k = m->bits + k * m->words; // read by every thread in this step, so nobody may write it
+        for (int i = t->lo; i < t->hi; i++)
+        {
+            uint64_t *row_i = m->bits + i * m->words;
+            if (i != k && ((row_i[k >> 6] >> (k & 63)) & 1))
+                bitrow_or(row_i, row_k, m->words);
+        }
+        pthread_barrier_wait(t->barrier); // row k + 1 may have changed in this step
+    }
+    return NULL;
+}
+
+GraphPtr transitive_closure(GraphPtr g, int numthreads)
+{
+    /*
+        Time Complexity: O(n^3 / (64 * p)) for p threads, as Warshall's algorithm does n steps, and in each step every row that reaches k ORs in row k 64 (or more, with SIMD) columns at a time.
+        Space Complexity: O(n^2 / 8) for the bit rows, plus O(n^2) for the returned graph.
+    */
+    assert(g != NULL);
+    if (numthreads < 1)
+        numthreads = 1;
+
+    BitMatrix *m = pack_rows(g, false);
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, numthreads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    ClosureTask *tasks = malloc(sizeof(ClosureTask) * numthreads);
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].m = m;
+        tasks[t].lo = (int)((long)g->numnodes * t / numthreads); // contiguous block of rows per thread
+        tasks[t].hi = (int)((long)g->numnodes * (t + 1) / numthreads);
+        tasks[t].barrier = &barrier;
+    }
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, closure_worker, &tasks[t]);
+    closure_worker(&tasks[0]); // the calling thread takes the first block
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    GraphPtr closure = create_graph(g->numnodes);
+    for (int r = 0; r < g->numnodes; r++)
+    {
+        const uint64_t *row = m->bits + r * m->words;
+        for (int c = 0; c < g->numnodes; c++)
+            closure->edges[r][c] = (row[c >> 6] >> (c & 63)) & 1; // unpack back into the bool matrix
+    }
+
+    pthread_barrier_destroy(&barrier);
+    free(threads);
+    free(tasks);
+    destroy_bitmatrix(m);
+    return closure;
+}
+
+typedef struct triangle_task
+{
+    BitMatrix *m;      // upper triangular neighbor rows
+    atomic_int *next;  // next block of rows nobody has taken yet
+    long count;        // triangles found by this thread
+} TriangleTask;
+
+static void *triangle_worker(void *arg)
+{
+    TriangleTask *t = arg;
+    BitMatrix *m = t->m;
+    t->count = 0;
+    while (true)
+    {
+        // later rows have fewer neighbors above them, so rows are handed out in small blocks instead of one big block per thread
+        int lo = atomic_fetch_add(t->next, ROW_BLOCK);
+        if (lo >= m->numnodes)
+            return NULL;
+        int hi = lo + ROW_BLOCK < m->numnodes ? lo + ROW_BLOCK : m->numnodes;
+
+        for (int i = lo; i < hi; i++)
+        {
+            const uint64_t *row_i = m->bits + i * m->words;
+            for (long w = i >> 6; w < m->words; w++)
+            {
+                uint64_t bits = row_i[w];
+                while (bits != 0)
+                {
+                    int j = (int)(w * 64 + __builtin_ctzll(bits)); // neighbor j > i
+                    bits &= bits - 1;
+                    // every k > j that is a neighbor of both i and j closes the triangle i < j < k, so each triangle is counted once
+                    long first = (j >> 6) & ~7L; // columns <= j are zero in row j, skip the lines before it
+                    t->count += bitrow_and_popcount(row_i + first, m->bits + j * m->words + first, m->words - first);
+                }
+            }
+        }
+    }
+}
+
+long count_triangles(GraphPtr g, int numthreads)
+{
+    /*
+        Time Complexity: O(m * n / (64 * p)) for p threads, as each edge i - j ANDs the rows of i and j and popcounts the result, 64 columns per word.
+        Space Complexity: O(n^2 / 8) for the bit rows.
+    */
+    assert(g != NULL);
+    if (numthreads < 1)
+        numthreads = 1;
+
+    BitMatrix *m = pack_rows(g, true);
+    atomic_int next;
+    atomic_init(&next, 0);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    TriangleTask *tasks = malloc(sizeof(TriangleTask) * numthreads);
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].m = m;
+        tasks[t].next = &next;
+    }
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, triangle_worker, &tasks[t]);
+    triangle_worker(&tasks[0]);
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    long total = 0;
+    for (int t = 0; t < numthreads; t++)
+        total += tasks[t].count; // each thread counted its own rows, no shared counter needed
+
+    free(threads);
+    free(tasks);
+    destroy_bitmatrix(m);
+    return total;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int dense_benchmark(int numnodes, int percent, int numthreads)
+{
+    /*
+        Time Complexity: O(n^3 / 64), dominated by the transitive closure.
+        Space Complexity: O(n^2), for the graph and its closure.
+    */
+    GraphPtr g = create_graph(numnodes);
+    srand(42); // same graph on every run
+    for (int r = 0; r < numnodes; r++)
+        for (int c = 0; c < numnodes; c++)
+            if (r != c && rand() % 100 < percent)
+                g->edges[r][c] = true;
+
+    double start = now_seconds();
+    long single = count_triangles(g, 1);
+    double single_time = now_seconds() - start;
+
+    start = now_seconds();
+    long triangles = count_triangles(g, numthreads);
+    double triangle_time = now_seconds() - start;
+
+    start = now_seconds();
+    GraphPtr closure = transitive_closure(g, numthreads);
+    double closure_time = now_seconds() - start;
+
+    long reachable = 0;
+    for (int r = 0; r < numnodes; r++)
+        for (int c = 0; c < numnodes; c++)
+            reachable += closure->edges[r][c];
+
+    printf("vertices %d | edge probability %d%%\n", numnodes, percent);
+    printf("triangles %ld | 1 thread: %.3f s | %d threads: %.3f s | counts match: %s\n", triangles, single_time, numthreads, triangle_time, single == triangles ? "true" : "false");
+    printf("reachable pairs %ld | closure with %d threads: %.3f s\n", reachable, numthreads, closure_time);
+
+    destroy_graph(closure);
+    destroy_graph(g);
+    return single == triangles ? 0 : 1;
+}
+
+void permute_graph(GraphPtr *g, const int *old_to_new)
+{
+    /*
+        Time Complexity: O(n^2), as every cell is copied once.
+        Space Complexity: O(n^2), for the new matrix. Cell (r, c) moves to (old_to_new[r], old_to_new[c]), weights move with their edges.
+        After an RCM or BFS order the edges sit close to the diagonal, so a row's edges share a few cache lines and the rows that a traversal visits one after the other are next to each other.
+    */
+    GraphPtr old = *g;
+    GraphPtr nu = create_graph(old->numnodes);
+    for (int r = 0; r < old->numnodes; r++)
+    {
+        bool *row = nu->edges[old_to_new[r]]; // the whole row moves to its new place
+        for (int c = 0; c < old->numnodes; c++)
+        {
+            if (!old->edges[r][c])
+                continue;
+            if (old->weights != NULL)
+                add_weighted_edge(nu, old_to_new[r], old_to_new[c], old->weights[r][c]);
+            else
+                row[old_to_new[c]] = true;
+        }
+    }
+
+    destroy_graph(old);
+    *g = nu;
+}
+
+int save_graph(GraphPtr g, const char *path)
+{
+    /*
+        Time Complexity: O(n^2), for building the CSR view. Rows are scanned in column order, so the neighbor lists are already sorted.
+        Space Complexity: O(n + m), for the CSR view.
+    */
+    assert(g != NULL);
+    CsrPtr c = graph_to_csr(g);
+    int status = save_snapshot(c, path);
+    destroy_csr(c);
+    return status;
+}
+
+static void batch_set(void *context, int thread, int source, const int *targets, long count)
+{
+    // the targets are sorted, so the row is written front to back
+    (void)thread;
+    GraphPtr g = context;
+    bool *row = g->edges[source];
+    for (long i = 0; i < count; i++)
+    {
+        if (!row[targets[i]] && g->weights != NULL)
+            g->weights[source][targets[i]] = 1; // new edge, drop the weight of a removed one
+        row[targets[i]] = true;
+    }
+}
+
+static void batch_clear(void *context, int thread, int source, const int *targets, long count)
+{
+    (void)thread;
+    bool *row = ((GraphPtr)context)->edges[source];
+    for (long i = 0; i < count; i++)
+        row[targets[i]] = false;
+}
+
+void add_edges(GraphPtr g, const int *pairs, long count, int numthreads)
+{
+    /*
+        Time Complexity: O(m / p + n) for a batch of m edges split over p threads (see batch.h). Every row is written by the one thread that owns it, in column order.
+        Space Complexity: O(m + n), for grouping the batch by row.
+    */
+    assert(g != NULL);
+    apply_edge_batch(pairs, count, g->numnodes, false, numthreads, batch_set, g);
+}
+
+void remove_edges(GraphPtr g, const int *pairs, long count, int numthreads)
+{
+    /*
+        Time Complexity: O(m / p + n), same as add_edges.
+        Space Complexity: O(m + n), for grouping the batch by row.
+    */
+    assert(g != NULL);
+    apply_edge_batch(pairs, count, g->numnodes, false, numthreads, batch_clear, g);
+}
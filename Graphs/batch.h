@@ -0,0 +1,160 @@
+// Batched edge updates, shared by adj_list.c and adj_matrix.c
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Applying a batch of edge updates one add_edge or remove_edge call at a time touches the vertices in whatever order the batch comes in,
+ * and every call scans (or allocates into) a list on its own. apply_edge_batch turns a batch into work that is cheap to apply and easy to split between threads:
+ *     1. the pairs (from, to) are bucketed by the thread that owns their source (undirected graphs also add (to, from)): thread t owns the vertices [n * t / p, n * (t + 1) / p)
+ *     2. every thread groups its bucket by source with a counting sort, the same way a CSR graph is built, which puts the targets of each of its vertices next to each other
+ *     3. every group is sorted (most are only a few edges) and its duplicates are dropped
+ *     4. every thread hands each of its vertices its group of targets, once (the apply callback of the representation)
+ * A vertex is only ever touched by the thread that owns it, so the callbacks need no locks and no atomics.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+// called once per source vertex in the batch, with its targets sorted and without duplicates. thread is the index of the calling worker.
+typedef void (*BatchApply)(void *context, int thread, int source, const int *targets, long count);
+
+// sort, deduplicate, group by source and apply count (from, to) pairs, stored as pairs[2 * i], pairs[2 * i + 1]
+void apply_edge_batch(const int *pairs, long count, int numnodes, bool both_directions, int numthreads, BatchApply apply, void *context);
+
+typedef struct batch_task
+{
+    int *pairs;       // this worker's bucket, (from, to) pairs
+    long size;        // number of pairs in it
+    int lo, hi;       // vertices [lo, hi) owned by this worker
+    int id;           // index of this worker
+    BatchApply apply; // callback of the representation
+    void *context;    // passed to apply
+} BatchTask;
+
+static inline int batch_owner(int v, int numnodes, int numthreads)
+{
+    return (int)((((long)v + 1) * numthreads - 1) / numnodes); // the last t with n * t / p <= v
+}
+
+static int compare_targets(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static void sort_targets(int *targets, long count)
+{
+    if (count > 16)
+    {
+        qsort(targets, count, sizeof(int), compare_targets);
+        return;
+    }
+    for (long i = 1; i < count; i++)
+    {
+        int v = targets[i]; // insertion sort, faster than qsort for the few edges most vertices get
+        long j = i;
+        for (; j > 0 && targets[j - 1] > v; j--)
+            targets[j] = targets[j - 1];
+        targets[j] = v;
+    }
+}
+
+static void *batch_worker(void *arg)
+{
+    BatchTask *t = arg;
+
+    // counting sort of the bucket by source
+    long *offsets = calloc(t->hi - t->lo + 1, sizeof(long));
+    int *targets = malloc(sizeof(int) * (t->size > 0 ? t->size : 1));
+    for (long i = 0; i < t->size; i++)
+        offsets[t->pairs[2 * i] - t->lo + 1]++;
+    for (int v = 0; v < t->hi - t->lo; v++)
+        offsets[v + 1] += offsets[v];
+    for (long i = 0; i < t->size; i++)
+        targets[offsets[t->pairs[2 * i] - t->lo]++] = t->pairs[2 * i + 1];
+    // every offset was moved to the end of its group, so group v is [v == 0 ? 0 : offsets[v - 1], offsets[v])
+
+    long start = 0;
+    for (int v = 0; v < t->hi - t->lo; v++)
+    {
+        long end = offsets[v];
+        if (end == start)
+            continue; // not in the batch
+        sort_targets(targets + start, end - start);
+        long unique = 1;
+        for (long i = start + 1; i < end; i++)
+            if (targets[i] != targets[start + unique - 1])
+                targets[start + unique++] = targets[i];
+        t->apply(t->context, t->id, t->lo + v, targets + start, unique);
+        start = end;
+    }
+
+    free(offsets);
+    free(targets);
+    return NULL;
+}
+
+void apply_edge_batch(const int *pairs, long count, int numnodes, bool both_directions, int numthreads, BatchApply apply, void *context)
+{
+    /*
+        Time Complexity: O(m + n / p) per thread for a batch of m pairs over p threads (plus O(k log k) for a vertex with more than 16 new edges), plus whatever apply costs.
+        Space Complexity: O(m + n), for the buckets and the group offsets.
+    */
+    if (numthreads < 1)
+        numthreads = 1;
+    if (numthreads > numnodes)
+        numthreads = numnodes > 0 ? numnodes : 1; // every worker owns at least one vertex
+
+    // count the pairs of every worker, then fill the buckets
+    long *sizes = calloc(numthreads, sizeof(long));
+    for (long i = 0; i < count; i++)
+    {
+        sizes[batch_owner(pairs[2 * i], numnodes, numthreads)]++;
+        if (both_directions)
+            sizes[batch_owner(pairs[2 * i + 1], numnodes, numthreads)]++;
+    }
+    BatchTask *tasks = malloc(sizeof(BatchTask) * numthreads);
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].pairs = malloc(sizeof(int) * 2 * (sizes[t] > 0 ? sizes[t] : 1));
+        tasks[t].size = 0;
+        tasks[t].lo = (int)((long)numnodes * t / numthreads);
+        tasks[t].hi = (int)((long)numnodes * (t + 1) / numthreads);
+        tasks[t].id = t;
+        tasks[t].apply = apply;
+        tasks[t].context = context;
+    }
+    for (long i = 0; i < count; i++)
+    {
+        int from = pairs[2 * i], to = pairs[2 * i + 1];
+        BatchTask *owner = &tasks[batch_owner(from, numnodes, numthreads)];
+        owner->pairs[2 * owner->size] = from;
+        owner->pairs[2 * owner->size++ + 1] = to;
+        if (both_directions && from != to) // a self loop is one group entry either way
+        {
+            owner = &tasks[batch_owner(to, numnodes, numthreads)];
+            owner->pairs[2 * owner->size] = to;
+            owner->pairs[2 * owner->size++ + 1] = from;
+        }
+    }
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, batch_worker, &tasks[t]);
+    batch_worker(&tasks[0]); // the calling thread takes the first bucket
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    for (int t = 0; t < numthreads; t++)
+        free(tasks[t].pairs);
+    free(tasks);
+    free(threads);
+    free(sizes);
+}
+
+#endif
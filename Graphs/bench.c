@@ -0,0 +1,138 @@
+// Benchmark for the adjacency list and adjacency matrix representations
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Generates a synthetic graph (R-MAT or Erdos-Renyi, see generators.h), builds it with add_edge and then times every basic operation on it:
+ * add_edge, has_edge, a full scan of every vertex's neighbors, remove_edge and add_vertex.
+ * The same file is compiled once per representation: it includes adj_list.c, or adj_matrix.c when BENCH_MATRIX is defined (see the bench target in the makefile).
+ * Results are printed as one JSON object per line, so runs at different sizes and densities can be collected and compared with any script:
+ *     {"representation": "list", "generator": "rmat", "vertices": 65536, "edges": 1048576, "operation": "add_edge", "count": 1048576, "seconds": 0.21, "ops_per_sec": 4993219}
+ * The last line of every run reports the bytes used per edge by the graph and the peak resident memory of the process.
+ *
+ * USAGE: ./bench_list <rmat | er> <scale> <edge factor>
+ * The graph has 2^scale vertices and 2^scale * edge factor edges.
+ */
+#define GRAPH_NO_MAIN
+#ifdef BENCH_MATRIX
+#include "adj_matrix.c"
+#define REPRESENTATION "matrix"
+#define DESTROY_GRAPH(g) destroy_graph(g)
+#define NEW_VERTICES 10 // every add_vertex copies the whole matrix
+#else
+#include "adj_list.c"
+#define REPRESENTATION "list"
+#define DESTROY_GRAPH(g) destroy_graph(&(g))
+#define NEW_VERTICES 1000
+#endif
+#include <sys/resource.h>
+#include "generators.h"
+
+#define MAX_QUERIES 100000  // has_edge calls per run
+#define MAX_REMOVALS 10000  // remove_edge calls per run
+
+static const char *generator_name; // "rmat" or "er", printed on every line
+
+static void report(GraphPtr g, long numedges, const char *operation, long count, double seconds)
+{
+    printf("{\"representation\": \"%s\", \"generator\": \"%s\", \"vertices\": %d, \"edges\": %ld, \"operation\": \"%s\", \"count\": %ld, \"seconds\": %.6f, \"ops_per_sec\": %.0f}\n",
+           REPRESENTATION, generator_name, g->numnodes, numedges, operation, count, seconds, seconds > 0 ? count / seconds : 0);
+}
+
+static long graph_bytes(GraphPtr g)
+{
+    // memory held by the graph itself, not counting malloc's own overhead
+#ifdef BENCH_MATRIX
+    long bytes = sizeof(graph) + sizeof(bool *) * g->numnodes + sizeof(bool) * (long)g->numnodes * g->numnodes;
+    if (g->weights != NULL)
+        bytes += sizeof(int *) * g->numnodes + sizeof(int) * (long)g->numnodes * g->numnodes;
+    return bytes;
+#else
+    long bytes = sizeof(Graph) + (sizeof(NodePtr) + sizeof(int)) * g->numnodes;
+    for (int i = 0; i < g->numnodes; i++)
+        bytes += sizeof(Node) * g->degrees[i];
+    return bytes;
+#endif
+}
+
+static long scan_neighbors(GraphPtr g)
+{
+    // visit every neighbor of every vertex, the access pattern of most traversals
+    long found = 0;
+#ifdef BENCH_MATRIX
+    for (int r = 0; r < g->numnodes; r++)
+        for (int c = 0; c < g->numnodes; c++)
+            found += g->edges[r][c];
+#else
+    for (int i = 0; i < g->numnodes; i++)
+        for (NodePtr nu = g->adjlists[i]; nu != NULL; nu = nu->next)
+            found++;
+#endif
+    return found;
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss; // kilobytes on Linux
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4 || (strcmp(argv[1], "rmat") != 0 && strcmp(argv[1], "er") != 0))
+    {
+        puts("USAGE: ./bench_list <rmat | er> <scale> <edge factor>");
+        return 1;
+    }
+
+    generator_name = argv[1];
+    int scale = atoi(argv[2]);
+    long numedges = (1L << scale) * atol(argv[3]);
+    EdgeListPtr el = strcmp(argv[1], "rmat") == 0 ? generate_rmat(scale, numedges, 0.57, 0.19, 0.19, 42) : generate_erdos_renyi(1 << scale, numedges, 42);
+
+    GraphPtr g = create_graph(el->numnodes);
+    double start = now_seconds();
+    for (long i = 0; i < el->numedges; i++)
+        add_edge(g, el->from[i], el->to[i]);
+    report(g, numedges, "add_edge", el->numedges, now_seconds() - start);
+    long bytes = graph_bytes(g); // measured now, before any edge is removed
+
+    // half of the queries hit an existing edge, the other half are random pairs (almost always misses)
+    uint64_t state = 7;
+    long queries = el->numedges < MAX_QUERIES ? el->numedges : MAX_QUERIES;
+    long hits = 0;
+    start = now_seconds();
+    for (long i = 0; i < queries; i++)
+    {
+        if (i % 2 == 0)
+            hits += has_edge(g, el->from[i], el->to[i]);
+        else
+            hits += has_edge(g, (int)(generator_next(&state) % g->numnodes), (int)(generator_next(&state) % g->numnodes));
+    }
+    report(g, numedges, "has_edge", queries, now_seconds() - start);
+
+    start = now_seconds();
+    long scanned = scan_neighbors(g);
+    report(g, numedges, "scan_neighbors", scanned, now_seconds() - start);
+
+    long removals = el->numedges < MAX_REMOVALS ? el->numedges : MAX_REMOVALS;
+    start = now_seconds();
+    for (long i = 0; i < removals; i++)
+        remove_edge(g, el->from[i], el->to[i]);
+    report(g, numedges, "remove_edge", removals, now_seconds() - start);
+
+    start = now_seconds();
+    for (int i = 0; i < NEW_VERTICES; i++)
+        add_vertex(&g);
+    report(g, numedges, "add_vertex", NEW_VERTICES, now_seconds() - start);
+
+    printf("{\"representation\": \"%s\", \"generator\": \"%s\", \"vertices\": %d, \"edges\": %ld, \"operation\": \"memory\", \"bytes_per_edge\": %.2f, \"peak_rss_kb\": %ld, \"has_edge_hits\": %ld}\n",
+           REPRESENTATION, generator_name, el->numnodes, numedges, el->numedges > 0 ? (double)bytes / el->numedges : 0, peak_rss_kb(), hits);
+
+    DESTROY_GRAPH(g);
+    destroy_edge_list(el);
+    return 0;
+}
@@ -0,0 +1,659 @@
+// Concurrent graph in C: lock-free readers over immutable versions, with epoch based reclamation
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * adj_list.c changes its lists in place, so a thread reading the graph while another one adds or removes an edge can follow a node that was just freed.
+ * The only safe way to share it is one lock around every query and every update, and then readers wait for each other and for the writer.
+ * This graph never changes anything a reader can see (read-copy-update):
+ *     - The graph is a Version: an array of chunks, each chunk holds CHUNK_SIZE row pointers, each row is a sorted array of neighbors. A published version is never modified.
+ *     - A writer builds the next version next to the current one. Only the rows it changes are copied, along with the chunks that point to them (and the chunk array),
+ *       everything else is shared with the current version. Publishing is a single atomic store of the root pointer, so a reader sees either all the changes of a write or none of them.
+ *       Edges are undirected like adj_list.c, and both directions of an edge are always published together.
+ *     - Readers take no lock: read_begin returns the current version, and the reader can query it for as long as it likes until read_end.
+ *       Each reader thread holds one of MAX_READERS slots from register_reader until unregister_reader. A thread that got no slot still reads, under the writer's mutex.
+ *     - Rows, chunks and versions the writer replaced can't be freed right away, a reader may still be looking at them. They are retired instead, and freed by epoch based reclamation:
+ *       a global epoch only advances once every active reader has seen the current one, so anything retired in epoch e is unreachable by every reader once the epoch reaches e + 2.
+ * Writers are serialized by a mutex, they never wait for readers.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#define CHUNK_BITS 10
+#define CHUNK_SIZE (1 << CHUNK_BITS) // rows per chunk, a write copies one chunk of row pointers (8 KB) for every chunk it touches
+#define MAX_READERS 64               // reader threads that can be registered at the same time
+#define READER_IDLE 0                // slot state of a reader outside read_begin / read_end
+
+typedef struct row
+{
+    int degree;      // number of neighbors
+    int neighbors[]; // sorted, never modified once the row is published
+} Row;
+
+typedef struct chunk
+{
+    Row *rows[CHUNK_SIZE]; // NULL for a vertex without neighbors
+} Chunk;
+
+typedef struct version
+{
+    int numnodes;   // number of nodes
+    long numedges;  // number of edges
+    int numchunks;  // number of chunks
+    Chunk **chunks; // vertex v is chunks[v >> CHUNK_BITS]->rows[v & (CHUNK_SIZE - 1)]
+} Version;
+
+typedef struct reader_slot
+{
+    _Atomic uint64_t state; // READER_IDLE, or (epoch << 1 | 1) while reading
+    atomic_bool taken;      // handed out by register_reader and not given back yet
+    char padding[55];       // one slot per cache line, so readers don't slow each other down
+} ReaderSlot;
+
+typedef struct ptr_vec
+{
+    void **items; // memory waiting to be freed
+    long size;
+    long cap;
+} PtrVec;
+
+typedef struct concurrent_graph
+{
+    _Atomic(Version *) current; // version readers get from read_begin
+    pthread_mutex_t writer;     // one writer at a time
+    Version *draft;             // next version, between write_begin and write_commit
+    _Atomic uint64_t epoch;     // global epoch, only advanced by writers
+    ReaderSlot slots[MAX_READERS];
+    atomic_int numreaders;      // one past the highest slot ever handed out, the writer checks slots below it
+    PtrVec limbo[3];            // limbo[e % 3] = memory retired in epoch e, only touched by the writer
+} ConcurrentGraph;
+typedef ConcurrentGraph *ConcurrentGraphPtr;
+
+ConcurrentGraphPtr create_concurrent_graph(int numnodes);          // create a graph
+void destroy_concurrent_graph(ConcurrentGraphPtr g);               // destroy the graph, no reader may be active
+int register_reader(ConcurrentGraphPtr g);                         // reserve a reader slot for the calling thread, -1 if all are taken
+void unregister_reader(ConcurrentGraphPtr g, int slot);            // give the slot back, for the next thread that registers
+const Version *read_begin(ConcurrentGraphPtr g, int slot);         // current version, valid until read_end, without a slot (-1) the writer waits until then
+void read_end(ConcurrentGraphPtr g, int slot);                     // done with the version returned by read_begin
+bool has_edge(const Version *v, int from_node, int to_node);       // check if there is an edge between two nodes
+const int *get_neighbors(const Version *v, int node, int *degree); // sorted neighbors of node, in place in the version
+void write_begin(ConcurrentGraphPtr g);                            // start building the next version
+void draft_add_edge(ConcurrentGraphPtr g, int from_node, int to_node);    // add an edge to the next version
+void draft_remove_edge(ConcurrentGraphPtr g, int from_node, int to_node); // remove an edge from the next version
+void draft_add_vertex(ConcurrentGraphPtr g);                       // add a vertex to the next version
+void write_commit(ConcurrentGraphPtr g);                           // publish the next version and reclaim what readers can no longer see
+void add_edge(ConcurrentGraphPtr g, int from_node, int to_node);   // add an edge, as its own write
+void remove_edge(ConcurrentGraphPtr g, int from_node, int to_node); // remove an edge, as its own write
+void add_vertex(ConcurrentGraphPtr g);                             // add a vertex, as its own write
+void print_graph(ConcurrentGraphPtr g);                            // print the current version
+int concurrent_benchmark(int numnodes, long numedges, int numreaders, long updates); // reader throughput while a writer streams updates, lock-free vs one big lock
+
+#ifndef GRAPH_NO_MAIN
+int main(int argc, char **argv)
+{
+    // USAGE: ./concurrent bench <numnodes> <numedges> <numreaders> <updates>
+    // example: gcc -O2 -pthread concurrent.c -o concurrent; ./concurrent bench 100000 1000000 4 20000
+    if (argc == 6 && strcmp(argv[1], "bench") == 0)
+        return concurrent_benchmark(atoi(argv[2]), atol(argv[3]), atoi(argv[4]), atol(argv[5]));
+
+    ConcurrentGraphPtr g = create_concurrent_graph(8); // create a graph with 8 nodes
+    int slot = register_reader(g);
+
+    // several edges published as one version
+    write_begin(g);
+    draft_add_edge(g, 0, 1);
+    draft_add_edge(g, 0, 2);
+    draft_add_edge(g, 1, 2);
+    draft_add_edge(g, 1, 3);
+    draft_add_edge(g, 2, 3);
+    write_commit(g);
+
+    const Version *old = read_begin(g, slot); // a reader holding on to the version while the writer goes on
+    add_edge(g, 3, 4);
+    add_vertex(g);
+    add_edge(g, 4, 8);
+    remove_edge(g, 0, 1);
+    printf("Old version | edge between %d and %d: %s | %d vertices\n", 3, 4, has_edge(old, 3, 4) ? "true" : "false", old->numnodes);
+    read_end(g, slot);
+
+    const Version *now = read_begin(g, slot);
+    printf("New version | edge between %d and %d: %s | %d vertices\n", 3, 4, has_edge(now, 3, 4) ? "true" : "false", now->numnodes);
+    read_end(g, slot);
+    unregister_reader(g, slot);
+
+    print_graph(g);
+    destroy_concurrent_graph(g); // destroy the graph, free the memory
+    return 0;
+}
+#endif
+
+static void ptr_vec_push(PtrVec *vec, void *item)
+{
+    if (vec->size == vec->cap)
+    {
+        vec->cap = vec->cap > 0 ? vec->cap * 2 : 64;
+        vec->items = realloc(vec->items, sizeof(void *) * vec->cap);
+    }
+    vec->items[vec->size++] = item;
+}
+
+static void ptr_vec_free_all(PtrVec *vec)
+{
+    for (long i = 0; i < vec->size; i++)
+        free(vec->items[i]);
+    vec->size = 0;
+}
+
+static Row *row_of(const Version *v, int node)
+{
+    return v->chunks[node >> CHUNK_BITS]->rows[node & (CHUNK_SIZE - 1)];
+}
+
+static int find_neighbor(const Row *r, int node)
+{
+    // index of the first neighbor >= node
+    int lo = 0, hi = r->degree;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (r->neighbors[mid] < node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+ConcurrentGraphPtr create_concurrent_graph(int numnodes)
+{
+    /*
+        Time Complexity: O(n), for the empty chunks.
+        Space Complexity: O(n), one row pointer per vertex.
+    */
+    ConcurrentGraphPtr g = calloc(1, sizeof(ConcurrentGraph));
+    if (g == NULL)
+        return NULL; // just in case calloc failed
+
+    Version *v = malloc(sizeof(Version));
+    v->numnodes = numnodes;
+    v->numedges = 0;
+    v->numchunks = (numnodes + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    v->chunks = malloc(sizeof(Chunk *) * (v->numchunks > 0 ? v->numchunks : 1));
+    for (int c = 0; c < v->numchunks; c++)
+        v->chunks[c] = calloc(1, sizeof(Chunk));
+
+    atomic_init(&g->current, v);
+    atomic_init(&g->epoch, 1);
+    atomic_init(&g->numreaders, 0);
+    for (int s = 0; s < MAX_READERS; s++)
+    {
+        atomic_init(&g->slots[s].state, READER_IDLE);
+        atomic_init(&g->slots[s].taken, false);
+    }
+    pthread_mutex_init(&g->writer, NULL);
+    return g;
+}
+
+void destroy_concurrent_graph(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(n + retired), every row of the current version and everything still waiting in limbo is freed.
+        Space Complexity: O(1)
+    */
+    Version *v = atomic_load(&g->current);
+    for (int c = 0; c < v->numchunks; c++)
+    {
+        for (int i = 0; i < CHUNK_SIZE; i++)
+            free(v->chunks[c]->rows[i]);
+        free(v->chunks[c]);
+    }
+    free(v->chunks);
+    free(v);
+    for (int e = 0; e < 3; e++)
+    {
+        ptr_vec_free_all(&g->limbo[e]);
+        free(g->limbo[e].items);
+    }
+    pthread_mutex_destroy(&g->writer);
+    free(g);
+}
+
+static bool valid_slot(int slot)
+{
+    return slot >= 0 && slot < MAX_READERS;
+}
+
+int register_reader(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(MAX_READERS) to find a free slot
+        Space Complexity: O(1)
+    */
+    for (int slot = 0; slot < MAX_READERS; slot++)
+    {
+        bool expected = false;
+        if (atomic_load_explicit(&g->slots[slot].taken, memory_order_relaxed) || !atomic_compare_exchange_strong(&g->slots[slot].taken, &expected, true))
+            continue; // another thread has it
+        int high = atomic_load(&g->numreaders);
+        while (high < slot + 1 && !atomic_compare_exchange_weak(&g->numreaders, &high, slot + 1))
+            ; // raise the high-water mark, unless a thread that took a later slot already did
+        return slot;
+    }
+    return -1;
+}
+
+void unregister_reader(ConcurrentGraphPtr g, int slot)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    if (!valid_slot(slot))
+        return;
+    atomic_store_explicit(&g->slots[slot].state, READER_IDLE, memory_order_release);
+    atomic_store_explicit(&g->slots[slot].taken, false, memory_order_release);
+}
+
+const Version *read_begin(ConcurrentGraphPtr g, int slot)
+{
+    /*
+        Time Complexity: O(1), with a slot no lock is taken, and the reader never waits for the writer or for other readers.
+        Space Complexity: O(1)
+    */
+    if (!valid_slot(slot))
+    {
+        // no slot to announce the epoch in, so hold the writer off instead: nothing is retired or freed until read_end
+        pthread_mutex_lock(&g->writer);
+        return atomic_load_explicit(&g->current, memory_order_relaxed);
+    }
+    // announce the epoch first, then load the root: the writer never frees anything reachable from a root loaded after the announcement
+    uint64_t epoch = atomic_load(&g->epoch);
+    atomic_store(&g->slots[slot].state, epoch << 1 | 1); // sequentially consistent, so the store is visible before the load below
+    return atomic_load_explicit(&g->current, memory_order_acquire);
+}
+
+void read_end(ConcurrentGraphPtr g, int slot)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    if (!valid_slot(slot))
+    {
+        pthread_mutex_unlock(&g->writer);
+        return;
+    }
+    atomic_store_explicit(&g->slots[slot].state, READER_IDLE, memory_order_release);
+}
+
+bool has_edge(const Version *v, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(log d), binary search in the sorted row.
+        Space Complexity: O(1)
+    */
+    assert(from_node >= 0 && from_node < v->numnodes);
+    assert(to_node >= 0 && to_node < v->numnodes);
+    const Row *r = row_of(v, from_node);
+    if (r == NULL)
+        return false;
+    int i = find_neighbor(r, to_node);
+    return i < r->degree && r->neighbors[i] == to_node;
+}
+
+const int *get_neighbors(const Version *v, int node, int *degree)
+{
+    /*
+        Time Complexity: O(1), the row is not copied, it stays valid until read_end.
+        Space Complexity: O(1)
+    */
+    const Row *r = row_of(v, node);
+    *degree = r != NULL ? r->degree : 0;
+    return r != NULL ? r->neighbors : NULL;
+}
+
+void write_begin(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(n / CHUNK_SIZE), for copying the chunk array.
+        Space Complexity: O(n / CHUNK_SIZE)
+    */
+    pthread_mutex_lock(&g->writer);
+    const Version *current = atomic_load_explicit(&g->current, memory_order_relaxed); // only writers store it, and we hold the lock
+    Version *draft = malloc(sizeof(Version));
+    *draft = *current;
+    draft->chunks = malloc(sizeof(Chunk *) * (current->numchunks > 0 ? current->numchunks : 1));
+    memcpy(draft->chunks, current->chunks, sizeof(Chunk *) * current->numchunks); // every chunk is shared until it is written to
+    g->draft = draft;
+}
+
+static void retire(ConcurrentGraphPtr g, void *p)
+{
+    // readers of the current version may still use p, free it two epochs from now
+    if (p != NULL)
+        ptr_vec_push(&g->limbo[atomic_load_explicit(&g->epoch, memory_order_relaxed) % 3], p);
+}
+
+static Chunk *writable_chunk(ConcurrentGraphPtr g, int c)
+{
+    // the draft's chunk c, copied first if it is still the one the current version uses
+    const Version *current = atomic_load_explicit(&g->current, memory_order_relaxed);
+    Chunk *chunk = g->draft->chunks[c];
+    if (c < current->numchunks && chunk == current->chunks[c])
+    {
+        Chunk *copy = malloc(sizeof(Chunk));
+        memcpy(copy, chunk, sizeof(Chunk));
+        retire(g, chunk);
+        g->draft->chunks[c] = chunk = copy;
+    }
+    return chunk;
+}
+
+static void replace_row(ConcurrentGraphPtr g, int node, Row *row)
+{
+    // point the draft at a new row for node, the old row is retired if the current version can see it and freed at once if only the draft could
+    const Version *current = atomic_load_explicit(&g->current, memory_order_relaxed);
+    Chunk *chunk = writable_chunk(g, node >> CHUNK_BITS);
+    Row *old = chunk->rows[node & (CHUNK_SIZE - 1)];
+    bool published = node < current->numnodes && old == row_of(current, node);
+    if (published)
+        retire(g, old);
+    else
+        free(old);
+    chunk->rows[node & (CHUNK_SIZE - 1)] = row;
+}
+
+static bool draft_insert(ConcurrentGraphPtr g, int node, int neighbor)
+{
+    // copy of node's row with neighbor inserted in order, false if it was already there
+    const Row *r = row_of(g->draft, node);
+    int degree = r != NULL ? r->degree : 0;
+    int i = r != NULL ? find_neighbor(r, neighbor) : 0;
+    if (i < degree && r->neighbors[i] == neighbor)
+        return false;
+
+    Row *nu = malloc(sizeof(Row) + sizeof(int) * (degree + 1));
+    nu->degree = degree + 1;
+    if (r != NULL)
+    {
+        memcpy(nu->neighbors, r->neighbors, sizeof(int) * i);
+        memcpy(nu->neighbors + i + 1, r->neighbors + i, sizeof(int) * (degree - i));
+    }
+    nu->neighbors[i] = neighbor;
+    replace_row(g, node, nu);
+    return true;
+}
+
+static bool draft_erase(ConcurrentGraphPtr g, int node, int neighbor)
+{
+    // copy of node's row without neighbor, false if it wasn't there
+    const Row *r = row_of(g->draft, node);
+    if (r == NULL)
+        return false;
+    int i = find_neighbor(r, neighbor);
+    if (i == r->degree || r->neighbors[i] != neighbor)
+        return false;
+
+    Row *nu = NULL; // an empty row is stored as NULL
+    if (r->degree > 1)
+    {
+        nu = malloc(sizeof(Row) + sizeof(int) * (r->degree - 1));
+        nu->degree = r->degree - 1;
+        memcpy(nu->neighbors, r->neighbors, sizeof(int) * i);
+        memcpy(nu->neighbors + i, r->neighbors + i + 1, sizeof(int) * (r->degree - i - 1));
+    }
+    replace_row(g, node, nu);
+    return true;
+}
+
+void draft_add_edge(ConcurrentGraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(d), both rows are copied. The first write to a chunk also copies its CHUNK_SIZE row pointers.
+        Space Complexity: O(d), for the new rows.
+    */
+    assert(g->draft != NULL);
+    assert(from_node >= 0 && from_node < g->draft->numnodes);
+    assert(to_node >= 0 && to_node < g->draft->numnodes);
+    if (!draft_insert(g, from_node, to_node))
+        return; // edge already exists
+    if (from_node != to_node)
+        draft_insert(g, to_node, from_node);
+    g->draft->numedges++;
+}
+
+void draft_remove_edge(ConcurrentGraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(d), both rows are copied without the edge.
+        Space Complexity: O(d), for the new rows.
+    */
+    assert(g->draft != NULL);
+    assert(from_node >= 0 && from_node < g->draft->numnodes);
+    assert(to_node >= 0 && to_node < g->draft->numnodes);
+    if (!draft_erase(g, from_node, to_node))
+        return; // no such edge
+    if (from_node != to_node)
+        draft_erase(g, to_node, from_node);
+    g->draft->numedges--;
+}
+
+void draft_add_vertex(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(n / CHUNK_SIZE) when a new chunk is needed (the chunk array grows), O(1) otherwise.
+        Space Complexity: O(CHUNK_SIZE) for a new chunk.
+    */
+    Version *draft = g->draft;
+    assert(draft != NULL);
+    if (draft->numnodes == draft->numchunks * CHUNK_SIZE)
+    {
+        draft->chunks = realloc(draft->chunks, sizeof(Chunk *) * (draft->numchunks + 1));
+        draft->chunks[draft->numchunks++] = calloc(1, sizeof(Chunk)); // new, so the current version never sees it
+    }
+    draft->numnodes++; // the new vertex's row is already NULL
+}
+
+static void try_advance(ConcurrentGraphPtr g)
+{
+    // move to the next epoch if every active reader has seen the current one, then free what was retired two epochs ago
+    uint64_t epoch = atomic_load(&g->epoch);
+    int numreaders = atomic_load(&g->numreaders);
+    for (int s = 0; s < numreaders && s < MAX_READERS; s++)
+    {
+        uint64_t state = atomic_load(&g->slots[s].state);
+        if (state != READER_IDLE && (state >> 1) != epoch)
+            return; // a reader from an older epoch may still be looking at memory retired then
+    }
+    atomic_store(&g->epoch, epoch + 1);
+    ptr_vec_free_all(&g->limbo[(epoch + 2) % 3]); // retired in epoch - 1, no active reader is older than epoch now
+}
+
+void write_commit(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(readers + freed), for checking the reader slots and freeing whatever became unreachable.
+        Space Complexity: O(1)
+    */
+    Version *old = atomic_load_explicit(&g->current, memory_order_relaxed);
+    atomic_store_explicit(&g->current, g->draft, memory_order_release); // every change of this write becomes visible at once
+    g->draft = NULL;
+    retire(g, old->chunks);
+    retire(g, old);
+    try_advance(g);
+    pthread_mutex_unlock(&g->writer);
+}
+
+void add_edge(ConcurrentGraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(d + n / CHUNK_SIZE), one write with one edge.
+        Space Complexity: O(d + CHUNK_SIZE)
+    */
+    write_begin(g);
+    draft_add_edge(g, from_node, to_node);
+    write_commit(g);
+}
+
+void remove_edge(ConcurrentGraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(d + n / CHUNK_SIZE), one write with one edge.
+        Space Complexity: O(d + CHUNK_SIZE)
+    */
+    write_begin(g);
+    draft_remove_edge(g, from_node, to_node);
+    write_commit(g);
+}
+
+void add_vertex(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(n / CHUNK_SIZE)
+        Space Complexity: O(n / CHUNK_SIZE)
+    */
+    write_begin(g);
+    draft_add_vertex(g);
+    write_commit(g);
+}
+
+void print_graph(ConcurrentGraphPtr g)
+{
+    /*
+        Time Complexity: O(n + m)
+        Space Complexity: O(1), the current version is printed in place.
+    */
+    const Version *v = atomic_load_explicit(&g->current, memory_order_acquire); // printing is not concurrent with writes
+    for (int i = 0; i < v->numnodes; i++)
+    {
+        int degree;
+        const int *neighbors = get_neighbors(v, i, &degree);
+        printf("Vertex %d | ", i);
+        for (int k = 0; k < degree; k++)
+            printf("%d -> ", neighbors[k]);
+        printf("NULL \n");
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct reader_task
+{
+    ConcurrentGraphPtr g;
+    bool locked;       // take the writer's mutex around every query, like a graph with one big lock
+    atomic_bool *done; // set once the writer has finished
+    uint64_t seed;     // vertices to query
+    long queries;      // queries answered by this reader
+    long violations;   // edges seen in one direction only, must stay 0
+} ReaderTask;
+
+static void *reader_worker(void *arg)
+{
+    ReaderTask *t = arg;
+    int slot = register_reader(t->g);
+    uint64_t state = t->seed;
+    t->queries = 0;
+    t->violations = 0;
+    while (!atomic_load_explicit(t->done, memory_order_relaxed))
+    {
+        if (t->locked)
+            pthread_mutex_lock(&t->g->writer);
+        const Version *v = read_begin(t->g, slot);
+
+        // look at a random vertex and check every one of its edges from the other end
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        int u = (int)((state >> 33) % v->numnodes);
+        int degree;
+        const int *neighbors = get_neighbors(v, u, &degree);
+        for (int k = 0; k < degree; k++)
+            t->violations += !has_edge(v, neighbors[k], u);
+        t->queries += degree + 1;
+
+        read_end(t->g, slot);
+        if (t->locked)
+            pthread_mutex_unlock(&t->g->writer);
+    }
+    unregister_reader(t->g, slot);
+    return NULL;
+}
+
+int concurrent_benchmark(int numnodes, long numedges, int numreaders, long updates)
+{
+    /*
+        Time Complexity: O(m log m) to build the graph, O(updates * (d + n / CHUNK_SIZE)) for the writer.
+        Space Complexity: O(n + m), plus whatever the readers keep from being reclaimed.
+    */
+    if (numreaders < 1 || numreaders > MAX_READERS)
+        numreaders = 1;
+    printf("vertices %d | edges %ld | readers %d | updates %ld\n", numnodes, numedges, numreaders, updates);
+    bool ok = true;
+
+    for (int locked = 1; locked >= 0; locked--)
+    {
+        ConcurrentGraphPtr g = create_concurrent_graph(numnodes);
+        srand(42); // same graph and updates in both runs
+        write_begin(g);
+        for (long i = 0; i < numedges; i++)
+            draft_add_edge(g, rand() % numnodes, rand() % numnodes);
+        write_commit(g);
+
+        atomic_bool done;
+        atomic_init(&done, false);
+        pthread_t *threads = malloc(sizeof(pthread_t) * numreaders);
+        ReaderTask *tasks = malloc(sizeof(ReaderTask) * numreaders);
+        for (int t = 0; t < numreaders; t++)
+        {
+            tasks[t].g = g;
+            tasks[t].locked = locked;
+            tasks[t].done = &done;
+            tasks[t].seed = t + 1;
+            pthread_create(&threads[t], NULL, reader_worker, &tasks[t]);
+        }
+
+        // the writer streams updates: every new edge is removed again a few updates later
+        int *pending = malloc(sizeof(int) * 2 * 64);
+        double start = now_seconds();
+        for (long i = 0; i < updates; i++)
+        {
+            int k = (int)(i % 64);
+            if (i >= 64)
+                remove_edge(g, pending[2 * k], pending[2 * k + 1]);
+            pending[2 * k] = rand() % numnodes;
+            pending[2 * k + 1] = rand() % numnodes;
+            add_edge(g, pending[2 * k], pending[2 * k + 1]);
+        }
+        double elapsed = now_seconds() - start;
+        atomic_store(&done, true);
+
+        long queries = 0, violations = 0;
+        for (int t = 0; t < numreaders; t++)
+        {
+            pthread_join(threads[t], NULL);
+            queries += tasks[t].queries;
+            violations += tasks[t].violations;
+        }
+        printf("%-9s | %.3f s | %.0f updates/s | %.0f reader queries/s | one-sided edges seen: %ld\n",
+               locked ? "big lock" : "lock-free", elapsed, updates / elapsed, queries / elapsed, violations);
+        ok = ok && violations == 0;
+
+        free(pending);
+        free(threads);
+        free(tasks);
+        destroy_concurrent_graph(g);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+// Compressed sparse row (CSR) view of a graph, shared by adj_list.c and adj_matrix.c
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * A CSR graph stores every adjacency list back to back in one array. The neighbors of vertex v are targets[offsets[v]] ... targets[offsets[v + 1] - 1],
+ * so walking a vertex's edges is a sequential read instead of following one pointer per edge.
+ * For example, the graph 0 - 1, 0 - 2, 1 - 2 (stored in both directions) is:
+ *     offsets = [0, 2, 4, 6]
+ *     targets = [1, 2, 0, 2, 0, 1]
+ * The view is read-only: it is built once from a graph (graph_to_csr in each representation) and then handed to the kernels that only read the graph.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef CSR_H
+#define CSR_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct csr
+{
+    int numnodes;  // number of vertices
+    long numedges; // number of entries in targets (an undirected edge counts twice)
+    long *offsets; // numnodes + 1 offsets into targets
+    int *targets;  // neighbors of every vertex, back to back
+    int *weights;  // weight of every entry in targets, NULL if the graph is unweighted
+} Csr;
+typedef Csr *CsrPtr;
+
+CsrPtr create_csr(int numnodes, long numedges, bool weighted); // allocate an empty CSR graph
+void destroy_csr(CsrPtr c);                                    // free a CSR graph
+
+CsrPtr create_csr(int numnodes, long numedges, bool weighted)
+{
+    /*
+        Time Complexity: O(1), the arrays are allocated but not filled.
+        Space Complexity: O(n + m), for the offsets, the targets and the optional weights.
+    */
+    CsrPtr c = malloc(sizeof(Csr));
+    c->numnodes = numnodes;
+    c->numedges = numedges;
+    c->offsets = malloc(sizeof(long) * (numnodes + 1));
+    c->targets = malloc(sizeof(int) * (numedges > 0 ? numedges : 1));
+    c->weights = weighted ? malloc(sizeof(int) * (numedges > 0 ? numedges : 1)) : NULL;
+    c->offsets[0] = 0;
+    return c;
+}
+
+void destroy_csr(CsrPtr c)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    free(c->offsets);
+    free(c->targets);
+    free(c->weights);
+    free(c);
+}
+
+#endif
@@ -0,0 +1,385 @@
+// Bulk edge list reader shared by adj_list.c and adj_matrix.c
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Reads a whole edge list file into flat arrays (from[i], to[i] and an optional weights[i]) so a graph can be built in one go instead of calling add_edge once per line.
+ * Two file formats are supported:
+ *     - text: one "u v" or "u v weight" line per edge, separated by spaces or tabs. Lines may be indented; lines whose first non-blank character is not a digit (comments such as "# ..." or "% ...") are skipped.
+ *       If no line has a weight the graph is unweighted, otherwise edges without a weight get weight 1. A vertex id of INT_MAX or more, or a weight above INT_MAX, fails the whole file.
+ *     - binary: the 8 byte magic "EDGEBIN1", then the number of nodes and the number of edges as uint64_t, then one (uint32_t u, uint32_t v) pair per edge.
+ *       Weighted graphs use the magic "EDGEBINW" and store (uint32_t u, uint32_t v, uint32_t weight) triples instead.
+ * The file is mmap'd instead of read through stdio. Text files are cut into one chunk per thread (each chunk starts right after a newline) and the chunks are parsed in parallel,
+ * straight into their final position in the arrays. Binary files need no parsing at all, the pairs are just split into the two arrays.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define EDGE_LIST_MAGIC "EDGEBIN1"          // first 8 bytes of a binary edge list
+#define EDGE_LIST_WEIGHTED_MAGIC "EDGEBINW" // first 8 bytes of a binary edge list with weights
+
+typedef struct edge_list
+{
+    int numnodes;  // one more than the largest vertex id in the file
+    long numedges; // number of edges read
+    int *from;     // from[i] is the first endpoint of edge i
+    int *to;       // to[i] is the second endpoint of edge i
+    int *weights;  // weights[i] is the weight of edge i, NULL if the file had no weights
+} EdgeList;
+typedef EdgeList *EdgeListPtr;
+
+typedef struct edge_list_header
+{
+    char magic[8];     // EDGE_LIST_MAGIC
+    uint64_t numnodes; // number of vertices
+    uint64_t numedges; // number of (u, v) pairs following the header
+} EdgeListHeader;
+
+typedef struct edge_list_chunk
+{
+    const char *begin, *end;  // part of the mapped file this thread parses
+    int *from, *to, *weights; // where this chunk's edges go in the final arrays
+    long numedges;            // lines counted in pass 1, edges actually parsed in pass 2
+    int maxnode;              // largest vertex id seen in this chunk
+    bool weighted;            // true if any line in this chunk had a weight
+    bool overflow;            // a vertex id or weight didn't fit in an int, the whole file is rejected
+} EdgeListChunk;
+
+EdgeListPtr read_edge_list(const char *path, int numthreads);   // read a text or binary edge list, NULL on failure
+int write_binary_edge_list(const char *path, EdgeListPtr el);   // write el in the binary format, 0 on success
+void destroy_edge_list(EdgeListPtr el);                         // free an edge list
+
+static void *edge_list_count_lines(void *arg)
+{
+    EdgeListChunk *c = arg;
+    c->numedges = 0;
+    for (const char *p = c->begin; p < c->end; p++)
+    {
+        p = memchr(p, '\n', c->end - p); // jump to the end of the line
+        c->numedges++;                   // every line holds at most one edge
+        if (p == NULL)
+            break; // last line has no newline
+    }
+    return NULL;
+}
+
+static const char *edge_list_number(const char *p, const char *end, long limit, long *value)
+{
+    // digits starting at p, NULL as soon as the value goes over limit (so it can't overflow a long either)
+    long x = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        x = x * 10 + (*p++ - '0');
+        if (x > limit)
+            return NULL;
+    }
+    *value = x;
+    return p;
+}
+
+static void *edge_list_parse(void *arg)
+{
+    EdgeListChunk *c = arg;
+    const char *p = c->begin;
+    long n = 0;
+    c->maxnode = -1;
+    c->weighted = false;
+    c->overflow = false;
+    while (p < c->end)
+    {
+        while (p < c->end && (*p == ' ' || *p == '\t'))
+            p++; // indentation
+        if (p == c->end)
+            break;
+        if (*p < '0' || *p > '9')
+        {
+            // comment or blank line, skip it
+            p = memchr(p, '\n', c->end - p);
+            if (p == NULL)
+                break;
+            p++;
+            continue;
+        }
+
+        long u, v;
+        p = edge_list_number(p, c->end, INT_MAX - 1, &u); // first endpoint, below INT_MAX so numnodes fits in an int
+        if (p == NULL)
+        {
+            c->overflow = true;
+            break;
+        }
+        while (p < c->end && (*p == ' ' || *p == '\t'))
+            p++; // separator
+        if (p == c->end || *p < '0' || *p > '9')
+        {
+            // line with a single number, not an edge
+            p = memchr(p, '\n', c->end - p);
+            if (p == NULL)
+                break;
+            p++;
+            continue;
+        }
+        p = edge_list_number(p, c->end, INT_MAX - 1, &v); // second endpoint
+        if (p == NULL)
+        {
+            c->overflow = true;
+            break;
+        }
+
+        long w = 1; // edges without a weight count as weight 1
+        while (p < c->end && (*p == ' ' || *p == '\t'))
+            p++; // separator
+        if (p < c->end && *p >= '0' && *p <= '9')
+        {
+            p = edge_list_number(p, c->end, INT_MAX, &w); // optional weight
+            if (p == NULL)
+            {
+                c->overflow = true;
+                break;
+            }
+            c->weighted = true;
+        }
+
+        c->from[n] = (int)u;
+        c->to[n] = (int)v;
+        c->weights[n] = (int)w;
+        n++;
+        if (u > c->maxnode)
+            c->maxnode = (int)u;
+        if (v > c->maxnode)
+            c->maxnode = (int)v;
+
+        p = memchr(p, '\n', c->end - p); // ignore anything else on the line
+        if (p == NULL)
+            break;
+        p++;
+    }
+    c->numedges = n;
+    return NULL;
+}
+
+static void edge_list_run(void *(*fn)(void *), EdgeListChunk *chunks, int numthreads)
+{
+    // run fn on every chunk, one thread per chunk, the calling thread takes the first one
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, fn, &chunks[t]);
+    fn(&chunks[0]);
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+}
+
+static EdgeListPtr edge_list_from_text(const char *data, size_t size, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p) for p threads, as each thread scans its own chunk twice (once to count lines, once to parse them).
+        Space Complexity: O(m), for the two endpoint arrays.
+    */
+    EdgeListChunk *chunks = calloc(numthreads, sizeof(EdgeListChunk));
+    const char *end = data + size;
+    const char *p = data;
+    for (int t = 0; t < numthreads; t++)
+    {
+        chunks[t].begin = p;
+        const char *q = (t == numthreads - 1) ? end : data + size * (t + 1) / numthreads; // even split of the bytes
+        if (q < p)
+            q = p;
+        if (q < end)
+        {
+            q = memchr(q, '\n', end - q); // move the cut right after the next newline so no line is split
+            q = (q == NULL) ? end : q + 1;
+        }
+        chunks[t].end = q;
+        p = q;
+    }
+
+    edge_list_run(edge_list_count_lines, chunks, numthreads); // pass 1: how many edges can each chunk hold at most
+
+    long total = 0;
+    for (int t = 0; t < numthreads; t++)
+        total += chunks[t].numedges;
+
+    EdgeListPtr el = malloc(sizeof(EdgeList));
+    el->from = malloc(sizeof(int) * (total > 0 ? total : 1));
+    el->to = malloc(sizeof(int) * (total > 0 ? total : 1));
+    el->weights = malloc(sizeof(int) * (total > 0 ? total : 1));
+
+    long offset = 0;
+    for (int t = 0; t < numthreads; t++)
+    {
+        chunks[t].from = el->from + offset; // each chunk writes straight into its own slice
+        chunks[t].to = el->to + offset;
+        chunks[t].weights = el->weights + offset;
+        offset += chunks[t].numedges;
+    }
+
+    edge_list_run(edge_list_parse, chunks, numthreads); // pass 2: parse the edges
+
+    // comment lines leave gaps at the end of some slices, close them up
+    el->numedges = 0;
+    el->numnodes = 0;
+    bool weighted = false, overflow = false;
+    for (int t = 0; t < numthreads; t++)
+    {
+        memmove(el->weights + el->numedges, chunks[t].weights, sizeof(int) * chunks[t].numedges);
+        weighted = weighted || chunks[t].weighted;
+        overflow = overflow || chunks[t].overflow;
+        memmove(el->from + el->numedges, chunks[t].from, sizeof(int) * chunks[t].numedges);
+        memmove(el->to + el->numedges, chunks[t].to, sizeof(int) * chunks[t].numedges);
+        el->numedges += chunks[t].numedges;
+        if (chunks[t].maxnode + 1 > el->numnodes)
+            el->numnodes = chunks[t].maxnode + 1;
+    }
+
+    if (!weighted)
+    {
+        free(el->weights); // every weight is 1, no need to keep them
+        el->weights = NULL;
+    }
+
+    free(chunks);
+    if (overflow)
+    {
+        destroy_edge_list(el); // the graph builders would index their arrays with a truncated id
+        return NULL;
+    }
+    return el;
+}
+
+static EdgeListPtr edge_list_from_binary(const char *data, size_t size)
+{
+    /*
+        Time Complexity: O(m), a single copy of the pairs, no parsing.
+        Space Complexity: O(m), for the two endpoint arrays.
+    */
+    EdgeListHeader header;
+    memcpy(&header, data, sizeof(EdgeListHeader));
+    bool weighted = memcmp(header.magic, EDGE_LIST_WEIGHTED_MAGIC, 8) == 0;
+    int stride = weighted ? 3 : 2; // uint32_t values per edge
+    if (header.numnodes > INT_MAX)
+        return NULL; // vertex ids are ints
+    if (header.numedges > (size - sizeof(EdgeListHeader)) / (stride * sizeof(uint32_t)))
+        return NULL; // truncated file, compared by division so a huge numedges can't wrap around
+
+    const uint32_t *pairs = (const uint32_t *)(data + sizeof(EdgeListHeader));
+    EdgeListPtr el = malloc(sizeof(EdgeList));
+    el->numnodes = (int)header.numnodes;
+    el->numedges = (long)header.numedges;
+    el->from = malloc(sizeof(int) * (el->numedges > 0 ? el->numedges : 1));
+    el->to = malloc(sizeof(int) * (el->numedges > 0 ? el->numedges : 1));
+    el->weights = weighted ? malloc(sizeof(int) * (el->numedges > 0 ? el->numedges : 1)) : NULL;
+    for (long i = 0; i < el->numedges; i++)
+    {
+        uint32_t u = pairs[stride * i], v = pairs[stride * i + 1];
+        if (u >= header.numnodes || v >= header.numnodes)
+        {
+            // the graph builders index their degree and offset arrays by endpoint
+            destroy_edge_list(el);
+            return NULL;
+        }
+        el->from[i] = (int)u;
+        el->to[i] = (int)v;
+        if (weighted)
+            el->weights[i] = (int)pairs[stride * i + 2];
+    }
+    return el;
+}
+
+EdgeListPtr read_edge_list(const char *path, int numthreads)
+{
+    /*
+        Time Complexity: O(size / p) for text files read with p threads, O(m) for binary files.
+        Space Complexity: O(m), for the two endpoint arrays. The file itself is mapped, not copied.
+    */
+    if (numthreads < 1)
+        numthreads = 1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL; // file doesn't exist
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0)
+    {
+        // empty file, empty graph
+        close(fd);
+        EdgeListPtr el = calloc(1, sizeof(EdgeList));
+        el->from = malloc(sizeof(int));
+        el->to = malloc(sizeof(int));
+        return el;
+    }
+
+    char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (data == MAP_FAILED)
+        return NULL;
+    madvise(data, size, MADV_SEQUENTIAL); // let the kernel read ahead aggressively
+
+    EdgeListPtr el;
+    if (size >= sizeof(EdgeListHeader) && (memcmp(data, EDGE_LIST_MAGIC, 8) == 0 || memcmp(data, EDGE_LIST_WEIGHTED_MAGIC, 8) == 0))
+        el = edge_list_from_binary(data, size); // binary fast path
+    else
+        el = edge_list_from_text(data, size, numthreads);
+
+    munmap(data, size);
+    return el;
+}
+
+int write_binary_edge_list(const char *path, EdgeListPtr el)
+{
+    /*
+        Time Complexity: O(m), as every pair is written once.
+        Space Complexity: O(1), pairs are written through stdio's buffer.
+    */
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return -1;
+
+    EdgeListHeader header;
+    memcpy(header.magic, el->weights != NULL ? EDGE_LIST_WEIGHTED_MAGIC : EDGE_LIST_MAGIC, 8);
+    header.numnodes = (uint64_t)el->numnodes;
+    header.numedges = (uint64_t)el->numedges;
+    fwrite(&header, sizeof(EdgeListHeader), 1, f);
+
+    for (long i = 0; i < el->numedges; i++)
+    {
+        uint32_t edge[3] = {(uint32_t)el->from[i], (uint32_t)el->to[i], el->weights != NULL ? (uint32_t)el->weights[i] : 1};
+        fwrite(edge, sizeof(uint32_t), el->weights != NULL ? 3 : 2, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+void destroy_edge_list(EdgeListPtr el)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    free(el->from);
+    free(el->to);
+    free(el->weights);
+    free(el);
+}
+
+#endif
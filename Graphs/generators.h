@@ -0,0 +1,100 @@
+// Synthetic graph generators, shared by the benchmarks
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Generates random edge lists (see edge_list.h) so graphs of any size can be built without a file:
+ *     - generate_rmat: R-MAT (recursive matrix) graphs. Each edge picks one quadrant of the adjacency matrix with probabilities a, b, c and 1 - a - b - c, then recurses into it until a single cell is left.
+ *       With the usual a = 0.57, b = c = 0.19 this gives a power-law degree distribution (a few huge hubs, a long tail of small vertices) like real social and web graphs.
+ *     - generate_erdos_renyi: uniform random graphs G(n, m), every edge joins two vertices picked uniformly at random, so every vertex has about the same degree.
+ * Both are deterministic for a given seed. Self loops are skipped, duplicate edges are kept (both representations accept them).
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "edge_list.h"
+
+EdgeListPtr generate_rmat(int scale, long numedges, double a, double b, double c, uint64_t seed); // 2^scale vertices, power-law degrees
+EdgeListPtr generate_erdos_renyi(int numnodes, long numedges, uint64_t seed);                     // uniform random edges
+
+static uint64_t generator_next(uint64_t *state)
+{
+    // splitmix64, much faster than rand() and with 64 good bits per call
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static double generator_uniform(uint64_t *state)
+{
+    return (generator_next(state) >> 11) * (1.0 / 9007199254740992.0); // 53 random bits in [0, 1)
+}
+
+static EdgeListPtr generator_alloc(int numnodes, long numedges)
+{
+    EdgeListPtr el = malloc(sizeof(EdgeList));
+    el->numnodes = numnodes;
+    el->numedges = 0;
+    el->from = malloc(sizeof(int) * (numedges > 0 ? numedges : 1));
+    el->to = malloc(sizeof(int) * (numedges > 0 ? numedges : 1));
+    el->weights = NULL; // generated graphs are unweighted
+    return el;
+}
+
+EdgeListPtr generate_rmat(int scale, long numedges, double a, double b, double c, uint64_t seed)
+{
+    /*
+        Time Complexity: O(m * scale), as every edge descends scale levels of the matrix.
+        Space Complexity: O(m), for the edge list.
+    */
+    if (scale < 0)
+        scale = 0;
+    EdgeListPtr el = generator_alloc(1 << scale, numedges);
+    uint64_t state = seed;
+    while (scale > 0 && el->numedges < numedges) // a single vertex only has a self loop
+    {
+        int u = 0, v = 0;
+        for (int level = 0; level < scale; level++)
+        {
+            double r = generator_uniform(&state);
+            int down = r >= a + b;               // bottom half of the matrix (quadrants c and d)
+            int right = (r >= a && r < a + b) || // top right quadrant (b)
+                        r >= a + b + c;          // bottom right quadrant (d)
+            u = (u << 1) | down;
+            v = (v << 1) | right;
+        }
+        if (u == v)
+            continue; // skip self loops
+        el->from[el->numedges] = u;
+        el->to[el->numedges] = v;
+        el->numedges++;
+    }
+    return el;
+}
+
+EdgeListPtr generate_erdos_renyi(int numnodes, long numedges, uint64_t seed)
+{
+    /*
+        Time Complexity: O(m)
+        Space Complexity: O(m), for the edge list.
+    */
+    EdgeListPtr el = generator_alloc(numnodes, numedges);
+    uint64_t state = seed;
+    while (numnodes > 1 && el->numedges < numedges)
+    {
+        int u = (int)(generator_next(&state) % numnodes);
+        int v = (int)(generator_next(&state) % numnodes);
+        if (u == v)
+            continue; // skip self loops
+        el->from[el->numedges] = u;
+        el->to[el->numedges] = v;
+        el->numedges++;
+    }
+    return el;
+}
+
+#endif
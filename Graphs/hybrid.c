@@ -0,0 +1,448 @@
+// Hybrid representation of graphs in C: a bit row or a sorted array per vertex, chosen by degree
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * adj_matrix.c answers has_edge in O(1) but always takes n^2 bytes, adj_list.c only stores the edges that exist but has_edge walks a whole list.
+ * Real graphs are usually both at once: a few hubs connected to a large part of the graph, and a long tail of vertices with a handful of neighbors.
+ * This representation picks the storage of every vertex on its own, from its degree:
+ *     - sparse rows: the neighbors in a sorted array, 4 bytes per edge, has_edge is a binary search
+ *     - dense rows: one bit per vertex of the graph (n / 8 bytes no matter how many edges), has_edge is a single bit test
+ * A row becomes dense once its degree reaches dense_degree and goes back to sparse when its degree drops below sparse_degree.
+ * The default dense_degree is n / 256. A bit row then takes up to 8 times the memory of the array it replaces, but only the hubs get that far, and the hubs are where most queries land
+ * (on an R-MAT graph with 2^16 vertices this keeps about 11 bytes per edge, against 7.5 for arrays only and 560 for bit rows only, and has_edge much closer to bit rows only than to arrays only).
+ * sparse_degree is half of dense_degree, so a row sitting right at the threshold doesn't convert back and forth on every add and remove.
+ * Both thresholds can be given to create_hybrid_graph: 0 makes every row dense (an adjacency matrix), INT_MAX makes every row sparse (an adjacency list).
+ * Edges are directed, like adj_matrix.c. Add both directions for an undirected graph.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "csr.h"
+#include "generators.h"
+
+#define HYBRID_MIN_DENSE 16 // smallest default dense_degree, a binary search over fewer neighbors is only a few compares anyway
+
+typedef struct row
+{
+    int degree;         // number of neighbors
+    int capacity;       // room in neighbors before it has to grow
+    int *neighbors;     // sorted neighbors of a sparse row, NULL for a dense row
+    uint64_t *bits;     // bit c is set if there is an edge to c, NULL for a sparse row
+} Row;
+
+typedef struct hybrid_graph
+{
+    int numnodes;      // number of nodes
+    long numedges;     // number of edges
+    int dense_degree;  // a sparse row with this many neighbors becomes a bit row
+    int sparse_degree; // a bit row with fewer neighbors than this becomes a sorted array again
+    Row *rows;         // one row per vertex
+} Graph;
+typedef Graph *GraphPtr;
+
+GraphPtr create_graph(int numnodes);                                                // create a graph with the default thresholds
+GraphPtr create_hybrid_graph(int numnodes, int dense_degree, int sparse_degree);    // create a graph with the given thresholds
+void destroy_graph(GraphPtr *g);                                                    // destroy the graph
+void add_edge(GraphPtr g, int from_node, int to_node);                              // add an edge between two nodes
+void remove_edge(GraphPtr g, int from_node, int to_node);                           // remove an edge between two nodes
+bool has_edge(GraphPtr g, int from_node, int to_node);                              // check if there is an edge between two nodes
+void add_vertex(GraphPtr *g);                                                       // add a vertex
+int get_neighbors(GraphPtr g, int v, int *out);                                     // copy the neighbors of v into out in increasing order, returns how many
+void print_graph(GraphPtr g);                                                       // print the graph
+CsrPtr graph_to_csr(GraphPtr g);                                                    // contiguous copy of the graph for read-only kernels
+long graph_bytes(GraphPtr g);                                                       // memory held by the graph
+int hybrid_benchmark(int scale, int edgefactor);                                    // memory and has_edge speed of sparse only, dense only and hybrid storage
+
+#ifndef GRAPH_NO_MAIN
+int main(int argc, char **argv)
+{
+    // USAGE: ./hybrid bench <scale> <edge factor>
+    // example: gcc -O2 hybrid.c -o hybrid; ./hybrid bench 14 16
+    if (argc == 4 && strcmp(argv[1], "bench") == 0)
+        return hybrid_benchmark(atoi(argv[2]), atoi(argv[3]));
+
+    GraphPtr g = create_hybrid_graph(8, 4, 2); // small thresholds, so the demo shows a row changing form
+
+    // vertex 0 is a hub, the other vertices have one or two neighbors
+    for (int i = 1; i < 8; i++)
+        add_edge(g, 0, i);
+    add_edge(g, 1, 2);
+    add_edge(g, 2, 3);
+    add_edge(g, 3, 1);
+
+    printf("Vertex 0 is stored as a %s row\n", g->rows[0].bits != NULL ? "dense" : "sparse");
+    printf("Is there an edge between %d and %d: %s\n", 0, 5, has_edge(g, 0, 5) ? "true" : "false");
+    printf("Is there an edge between %d and %d: %s\n", 1, 3, has_edge(g, 1, 3) ? "true" : "false");
+
+    add_vertex(&g);
+    add_edge(g, 0, 8);
+    print_graph(g);
+
+    for (int i = 1; i < 8; i++)
+        remove_edge(g, 0, i); // vertex 0 drops below sparse_degree
+    printf("Vertex 0 is stored as a %s row\n", g->rows[0].bits != NULL ? "dense" : "sparse");
+    print_graph(g);
+
+    destroy_graph(&g); // destroy the graph, free the memory
+    return 0;
+}
+#endif
+
+static long row_words(int numnodes)
+{
+    return (numnodes + 63) / 64; // 64 columns per word
+}
+
+GraphPtr create_hybrid_graph(int numnodes, int dense_degree, int sparse_degree)
+{
+    /*
+        Time Complexity: O(n), every row starts out as an empty sparse row.
+        Space Complexity: O(n), for the rows.
+    */
+    GraphPtr g = malloc(sizeof(Graph));
+    if (g == NULL)
+        return NULL; // just in case malloc failed
+
+    g->numnodes = numnodes;
+    g->numedges = 0;
+    g->dense_degree = dense_degree;
+    g->sparse_degree = sparse_degree < dense_degree ? sparse_degree : dense_degree; // a new dense row must not be sparse right away
+    g->rows = calloc(numnodes > 0 ? numnodes : 1, sizeof(Row));
+    if (g->rows == NULL)
+    {
+        free(g);
+        return NULL;
+    }
+    if (dense_degree == 0)
+        for (int i = 0; i < numnodes; i++)
+            g->rows[i].bits = calloc(row_words(numnodes) > 0 ? row_words(numnodes) : 1, sizeof(uint64_t)); // every row is dense from the start
+    return g;
+}
+
+GraphPtr create_graph(int numnodes)
+{
+    /*
+        Time Complexity: O(n)
+        Space Complexity: O(n)
+    */
+    int dense_degree = numnodes / 256; // at n / 32 both forms would take the same memory, see the description at the top for why rows go dense earlier
+    if (dense_degree < HYBRID_MIN_DENSE)
+        dense_degree = HYBRID_MIN_DENSE;
+    return create_hybrid_graph(numnodes, dense_degree, dense_degree / 2);
+}
+
+void destroy_graph(GraphPtr *g)
+{
+    /*
+        Time Complexity: O(n), as every row is freed.
+        Space Complexity: O(1)
+    */
+    for (int i = 0; i < (*g)->numnodes; i++)
+    {
+        free((*g)->rows[i].neighbors);
+        free((*g)->rows[i].bits);
+    }
+    free((*g)->rows);
+    free(*g);
+    *g = NULL;
+}
+
+static int find_neighbor(const Row *r, int v)
+{
+    // index of the first neighbor >= v in a sparse row
+    int lo = 0, hi = r->degree;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (r->neighbors[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void make_dense(GraphPtr g, Row *r)
+{
+    // move the sorted array into a bit row
+    r->bits = calloc(row_words(g->numnodes), sizeof(uint64_t));
+    for (int i = 0; i < r->degree; i++)
+        r->bits[r->neighbors[i] >> 6] |= (uint64_t)1 << (r->neighbors[i] & 63);
+    free(r->neighbors);
+    r->neighbors = NULL;
+    r->capacity = 0;
+}
+
+static void make_sparse(GraphPtr g, Row *r)
+{
+    // move the bit row into a sorted array, reading the set bits in order keeps it sorted
+    r->capacity = r->degree > 0 ? r->degree : 1;
+    r->neighbors = malloc(sizeof(int) * r->capacity);
+    int k = 0;
+    for (long w = 0; w < row_words(g->numnodes); w++)
+    {
+        uint64_t bits = r->bits[w];
+        while (bits != 0)
+        {
+            r->neighbors[k++] = (int)(w * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    free(r->bits);
+    r->bits = NULL;
+}
+
+void add_edge(GraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(1) for a dense row, O(d) for a sparse row, as the neighbors after to_node are shifted to keep the array sorted.
+        Converting a row to a bit row is O(n / 64 + d), and only happens once every time the row crosses dense_degree.
+        Space Complexity: O(1) amortized, the array doubles when it is full.
+    */
+
+    // safety checks
+    assert(g != NULL);
+    assert(from_node >= 0 && from_node < g->numnodes);
+    assert(to_node >= 0 && to_node < g->numnodes);
+
+    Row *r = &g->rows[from_node];
+    if (r->bits != NULL)
+    {
+        uint64_t mask = (uint64_t)1 << (to_node & 63);
+        if (r->bits[to_node >> 6] & mask)
+            return; // edge already exists
+        r->bits[to_node >> 6] |= mask;
+    }
+    else
+    {
+        int i = find_neighbor(r, to_node);
+        if (i < r->degree && r->neighbors[i] == to_node)
+            return; // edge already exists
+        if (r->degree == r->capacity)
+        {
+            r->capacity = r->capacity > 0 ? r->capacity * 2 : 4;
+            r->neighbors = realloc(r->neighbors, sizeof(int) * r->capacity);
+        }
+        memmove(r->neighbors + i + 1, r->neighbors + i, sizeof(int) * (r->degree - i));
+        r->neighbors[i] = to_node;
+    }
+    r->degree++;
+    g->numedges++;
+
+    if (r->bits == NULL && r->degree >= g->dense_degree)
+        make_dense(g, r); // the row is now big enough that a bit row is no larger and much faster to query
+}
+
+void remove_edge(GraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(1) for a dense row, O(d) for a sparse row, as the neighbors after to_node are shifted down.
+        Converting a bit row back to an array is O(n / 64 + d), and only happens when the row drops below sparse_degree.
+        Space Complexity: O(1)
+    */
+
+    // safety checks
+    assert(g != NULL);
+    assert(from_node >= 0 && from_node < g->numnodes);
+    assert(to_node >= 0 && to_node < g->numnodes);
+
+    Row *r = &g->rows[from_node];
+    if (r->bits != NULL)
+    {
+        uint64_t mask = (uint64_t)1 << (to_node & 63);
+        if (!(r->bits[to_node >> 6] & mask))
+            return; // no such edge
+        r->bits[to_node >> 6] &= ~mask;
+    }
+    else
+    {
+        int i = find_neighbor(r, to_node);
+        if (i == r->degree || r->neighbors[i] != to_node)
+            return; // no such edge
+        memmove(r->neighbors + i, r->neighbors + i + 1, sizeof(int) * (r->degree - i - 1));
+    }
+    r->degree--;
+    g->numedges--;
+
+    if (r->bits != NULL && r->degree < g->sparse_degree)
+        make_sparse(g, r);
+}
+
+bool has_edge(GraphPtr g, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(1) for a dense row, O(log d) for a sparse row, where d < dense_degree.
+        Space Complexity: O(1)
+    */
+
+    // safety checks
+    assert(g != NULL);
+    assert(from_node >= 0 && from_node < g->numnodes);
+    assert(to_node >= 0 && to_node < g->numnodes);
+
+    const Row *r = &g->rows[from_node];
+    if (r->bits != NULL)
+        return (r->bits[to_node >> 6] >> (to_node & 63)) & 1;
+    int i = find_neighbor(r, to_node);
+    return i < r->degree && r->neighbors[i] == to_node;
+}
+
+void add_vertex(GraphPtr *g)
+{
+    /*
+        Time Complexity: O(n), the row array is reallocated. Bit rows only grow when the new vertex needs one more word, every 64 vertices.
+        Space Complexity: O(1) amortized per vertex, plus one word per dense row every 64 vertices.
+    */
+    GraphPtr h = *g;
+    long old_words = row_words(h->numnodes);
+    h->numnodes++;
+    h->rows = realloc(h->rows, sizeof(Row) * h->numnodes);
+    memset(&h->rows[h->numnodes - 1], 0, sizeof(Row));
+
+    long words = row_words(h->numnodes);
+    for (int i = 0; i < h->numnodes; i++)
+    {
+        Row *r = &h->rows[i];
+        if (i == h->numnodes - 1 && h->dense_degree == 0)
+            r->bits = calloc(words, sizeof(uint64_t)); // every row is dense in this graph
+        else if (r->bits != NULL && words != old_words)
+        {
+            r->bits = realloc(r->bits, sizeof(uint64_t) * words);
+            r->bits[words - 1] = 0; // the new column starts empty
+        }
+    }
+}
+
+int get_neighbors(GraphPtr g, int v, int *out)
+{
+    /*
+        Time Complexity: O(d) for a sparse row, O(n / 64 + d) for a dense row.
+        Space Complexity: O(1), out must have room for the degree of v.
+    */
+    const Row *r = &g->rows[v];
+    if (r->bits == NULL)
+    {
+        memcpy(out, r->neighbors, sizeof(int) * r->degree);
+        return r->degree;
+    }
+
+    int k = 0;
+    for (long w = 0; w < row_words(g->numnodes); w++)
+    {
+        uint64_t bits = r->bits[w];
+        while (bits != 0)
+        {
+            out[k++] = (int)(w * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    return k;
+}
+
+void print_graph(GraphPtr g)
+{
+    /*
+        Time Complexity: O(n^2 / 64 + m), as dense rows are scanned a word at a time.
+        Space Complexity: O(n), for the neighbors of one vertex.
+    */
+    int *neighbors = malloc(sizeof(int) * (g->numnodes > 0 ? g->numnodes : 1));
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        int degree = get_neighbors(g, i, neighbors);
+        printf("Vertex %d (%s) | ", i, g->rows[i].bits != NULL ? "dense" : "sparse");
+        for (int k = 0; k < degree; k++)
+            printf("%d -> ", neighbors[k]);
+        printf("NULL \n");
+    }
+    free(neighbors);
+}
+
+CsrPtr graph_to_csr(GraphPtr g)
+{
+    /*
+        Time Complexity: O(n + m) for sparse rows, plus O(n / 64) for every dense row.
+        Space Complexity: O(n + m), for the CSR arrays (see csr.h). Neighbors come out sorted.
+    */
+    CsrPtr c = create_csr(g->numnodes, g->numedges, false);
+    for (int i = 0; i < g->numnodes; i++)
+        c->offsets[i + 1] = c->offsets[i] + get_neighbors(g, i, c->targets + c->offsets[i]);
+    return c;
+}
+
+long graph_bytes(GraphPtr g)
+{
+    /*
+        Time Complexity: O(n)
+        Space Complexity: O(1)
+    */
+    long bytes = sizeof(Graph) + sizeof(Row) * g->numnodes;
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        if (g->rows[i].bits != NULL)
+            bytes += sizeof(uint64_t) * row_words(g->numnodes);
+        else
+            bytes += sizeof(int) * g->rows[i].capacity;
+    }
+    return bytes;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int hybrid_benchmark(int scale, int edgefactor)
+{
+    /*
+        Time Complexity: O(m log d + q) per configuration, for building the graph and running q queries.
+        Space Complexity: O(n^2 / 8) for the dense only configuration, O(n + m) for the others.
+    */
+    const char *names[] = {"sparse only", "dense only", "hybrid"};
+    int numnodes = 1 << scale;
+    EdgeListPtr el = generate_rmat(scale, (long)numnodes * edgefactor, 0.57, 0.19, 0.19, 42); // power-law degrees: a few hubs, many small vertices
+    long queries = 4 * el->numedges;
+    long results[3];
+    printf("vertices %d | generated edges %ld | has_edge queries %ld\n", numnodes, el->numedges, queries);
+
+    for (int k = 0; k < 3; k++)
+    {
+        GraphPtr g = k == 0 ? create_hybrid_graph(numnodes, INT_MAX, INT_MAX) : k == 1 ? create_hybrid_graph(numnodes, 0, 0) : create_graph(numnodes);
+
+        double start = now_seconds();
+        for (long i = 0; i < el->numedges; i++)
+            add_edge(g, el->from[i], el->to[i]);
+        double build_time = now_seconds() - start;
+
+        // queries follow the edge distribution, so most of them land on the hubs, like a real workload would
+        uint64_t state = 7;
+        long hits = 0;
+        start = now_seconds();
+        for (long q = 0; el->numedges > 0 && q < queries; q++) // no edges, no queries: there is nothing to pick a source from
+        {
+            long e = (long)(generator_next(&state) % el->numedges);
+            hits += has_edge(g, el->from[e], (int)(generator_next(&state) % numnodes));
+        }
+        double query_time = now_seconds() - start;
+        results[k] = hits;
+
+        int dense = 0;
+        for (int i = 0; i < numnodes; i++)
+            dense += g->rows[i].bits != NULL;
+        printf("%-11s | dense rows %6d | %7.2f bytes per edge | build %.3f s | %.1f ns per has_edge\n",
+               names[k], dense, g->numedges > 0 ? (double)graph_bytes(g) / g->numedges : 0.0, build_time, queries > 0 ? query_time * 1e9 / queries : 0.0);
+        destroy_graph(&g);
+    }
+
+    destroy_edge_list(el);
+    return results[0] == results[1] && results[1] == results[2] ? 0 : 1; // all three must answer the same
+}
@@ -0,0 +1,278 @@
+// PageRank and personalized PageRank on a CSR graph (see csr.h)
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * PageRank gives every vertex a score: the chance that a random walk is at that vertex after many steps, if at every step the walk follows
+ * a random edge with probability damping, and jumps to a random vertex otherwise (personalized PageRank jumps according to a given distribution instead, e.g. always back to one vertex).
+ * Every iteration computes, for every vertex v:
+ *     rank'[v] = (1 - damping) * jump[v] + damping * (sum of rank[u] / outdegree[u] over the edges u -> v + dangling * jump[v])
+ * where dangling is the rank held by vertices without out-edges, which is spread like a jump. Iterations stop once the ranks change by less than tolerance in total (L1 norm).
+ * The kernel pulls: each vertex sums the contributions of its in-neighbors, so every rank'[v] is written by exactly one thread and no atomics are needed.
+ * Reading contrib[u] for every in-edge is a random access, so the in-edges are split into segments by source: segment s only holds the edges whose source is in
+ * [s * PAGERANK_SEGMENT, (s + 1) * PAGERANK_SEGMENT), and its slice of contrib (256 KB) stays in the cache while the segment is processed.
+ * Each thread owns a fixed range of destination vertices in every segment, so segments need no barrier between them either.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef PAGERANK_H
+#define PAGERANK_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "csr.h"
+
+#define PAGERANK_SEGMENT (1 << 15) // sources per segment, 32768 doubles = 256 KB of contributions
+
+// ranks of every vertex, summing to 1. personalization is the jump distribution (it must sum to 1), NULL for uniform jumps.
+// iteration_seconds, if not NULL, gets the time of every iteration. Returns the number of iterations run.
+int pagerank(CsrPtr c, double *rank, const double *personalization, double damping, double tolerance, int maxiters, int numthreads, double *iteration_seconds);
+
+typedef struct pagerank_segment
+{
+    int numdests;  // vertices with at least one in-edge from this segment
+    int *dests;    // those vertices, increasing
+    long *offsets; // in-edges of dests[i] are sources[offsets[i]] ... sources[offsets[i + 1] - 1]
+    int *sources;  // sources of the in-edges, all inside the segment
+} PagerankSegment;
+
+typedef struct pagerank_shared
+{
+    CsrPtr g;                   // graph being ranked
+    PagerankSegment *segments;  // in-edges split by source
+    int numsegments;
+    double *rank;               // ranks of the current iteration, then of the next
+    double *contrib;            // rank[u] / outdegree[u]
+    double *sums;               // pulled contributions of every vertex
+    const double *jump;         // personalization, NULL for uniform
+    double damping;
+    double tolerance;
+    int maxiters;
+    int numthreads;
+    double *dangling;           // rank of vertices without out-edges, per thread
+    double *error;              // L1 change of the ranks, per thread
+    double *iteration_seconds;  // time of every iteration, may be NULL
+    int iterations;             // iterations done, set by thread 0
+    bool converged;             // set by thread 0
+    pthread_barrier_t barrier;  // workers meet here between the phases of an iteration
+} PagerankShared;
+
+typedef struct pagerank_task
+{
+    PagerankShared *shared; // state shared by all workers
+    int id;                 // index of this worker
+} PagerankTask;
+
+static double pagerank_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_dests(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static PagerankSegment *build_segments(CsrPtr c, int *numsegments)
+{
+    /*
+        Time Complexity: O(m + sum of d_s * log(d_s)) for the d_s destinations of every segment s: no step looks at every vertex once per segment
+        Space Complexity: O(n + m)
+    */
+    // transpose the graph, one small CSR of in-edges per source segment
+    int n = c->numnodes;
+    *numsegments = (n + PAGERANK_SEGMENT - 1) / PAGERANK_SEGMENT;
+    PagerankSegment *segments = calloc(*numsegments > 0 ? *numsegments : 1, sizeof(PagerankSegment));
+    long *count = calloc(n > 0 ? n : 1, sizeof(long)); // in-edges of every vertex from the current segment, 0 again after every segment
+    int *touched = malloc(sizeof(int) * (n > 0 ? n : 1)); // vertices with a nonzero count, in the order they were first seen
+
+    for (int s = 0; s < *numsegments; s++)
+    {
+        int lo = s * PAGERANK_SEGMENT, hi = lo + PAGERANK_SEGMENT < n ? lo + PAGERANK_SEGMENT : n;
+        PagerankSegment *seg = &segments[s];
+        long edges = c->offsets[hi] - c->offsets[lo];
+        for (long e = c->offsets[lo]; e < c->offsets[hi]; e++)
+        {
+            int v = c->targets[e];
+            if (count[v]++ == 0)
+                touched[seg->numdests++] = v;
+        }
+        qsort(touched, seg->numdests, sizeof(int), compare_dests); // dests are kept increasing for first_dest
+
+        seg->dests = malloc(sizeof(int) * (seg->numdests > 0 ? seg->numdests : 1));
+        seg->offsets = malloc(sizeof(long) * (seg->numdests + 1));
+        seg->sources = malloc(sizeof(int) * (edges > 0 ? edges : 1));
+        seg->offsets[0] = 0;
+        for (int k = 0; k < seg->numdests; k++)
+        {
+            int v = touched[k];
+            seg->dests[k] = v;
+            seg->offsets[k + 1] = seg->offsets[k] + count[v];
+            count[v] = seg->offsets[k]; // from now on, the next free position of v in sources
+        }
+
+        for (int u = lo; u < hi; u++)
+            for (long e = c->offsets[u]; e < c->offsets[u + 1]; e++)
+                seg->sources[count[c->targets[e]]++] = u; // sources come out in increasing order, so contrib is read front to back
+        for (int k = 0; k < seg->numdests; k++)
+            count[touched[k]] = 0; // only the vertices this segment reached
+    }
+
+    free(touched);
+    free(count);
+    return segments;
+}
+
+static int first_dest(const PagerankSegment *seg, int v)
+{
+    // index of the first destination >= v
+    int lo = 0, hi = seg->numdests;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (seg->dests[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void *pagerank_worker(void *arg)
+{
+    PagerankTask *task = arg;
+    PagerankShared *s = task->shared;
+    int id = task->id;
+    int n = s->g->numnodes;
+    int lo = (int)((long)n * id / s->numthreads); // vertices [lo, hi) belong to this worker in every phase
+    int hi = (int)((long)n * (id + 1) / s->numthreads);
+
+    for (int iter = 0; iter < s->maxiters; iter++)
+    {
+        double start = id == 0 ? pagerank_now() : 0;
+
+        // phase 1: what every vertex gives to each of its out-neighbors
+        double dangling = 0;
+        for (int u = lo; u < hi; u++)
+        {
+            long degree = s->g->offsets[u + 1] - s->g->offsets[u];
+            s->contrib[u] = degree > 0 ? s->rank[u] / degree : 0;
+            if (degree == 0)
+                dangling += s->rank[u];
+            s->sums[u] = 0;
+        }
+        s->dangling[id] = dangling;
+        pthread_barrier_wait(&s->barrier);
+
+        // phase 2: pull, one segment at a time so its contributions stay in the cache
+        for (int k = 0; k < s->numsegments; k++)
+        {
+            const PagerankSegment *seg = &s->segments[k];
+            for (int i = first_dest(seg, lo); i < seg->numdests && seg->dests[i] < hi; i++)
+            {
+                double sum = 0;
+                for (long e = seg->offsets[i]; e < seg->offsets[i + 1]; e++)
+                    sum += s->contrib[seg->sources[e]];
+                s->sums[seg->dests[i]] += sum; // only this worker writes its destinations
+            }
+        }
+
+        // phase 3: new ranks, every worker adds up the dangling rank on its own instead of waiting for one to do it
+        double total_dangling = 0;
+        for (int t = 0; t < s->numthreads; t++)
+            total_dangling += s->dangling[t];
+        double error = 0;
+        for (int v = lo; v < hi; v++)
+        {
+            double jump = s->jump != NULL ? s->jump[v] : 1.0 / n;
+            double next = (1 - s->damping) * jump + s->damping * (s->sums[v] + total_dangling * jump);
+            error += next > s->rank[v] ? next - s->rank[v] : s->rank[v] - next;
+            s->rank[v] = next; // nobody reads rank[v] again in this iteration, contrib already holds it
+        }
+        s->error[id] = error;
+        pthread_barrier_wait(&s->barrier);
+
+        if (id == 0)
+        {
+            double total_error = 0;
+            for (int t = 0; t < s->numthreads; t++)
+                total_error += s->error[t];
+            s->iterations = iter + 1;
+            s->converged = total_error < s->tolerance;
+            if (s->iteration_seconds != NULL)
+                s->iteration_seconds[iter] = pagerank_now() - start;
+        }
+        pthread_barrier_wait(&s->barrier); // everyone sees the same decision
+        if (s->converged)
+            break;
+    }
+    return NULL;
+}
+
+int pagerank(CsrPtr c, double *rank, const double *personalization, double damping, double tolerance, int maxiters, int numthreads, double *iteration_seconds)
+{
+    /*
+        Time Complexity: O((n + m) / p) per iteration for p threads, plus O(m + sum of d_s * log(d_s)) once to build the segments (see build_segments).
+        Space Complexity: O(n + m), for the segments (the transpose of the graph), the contributions and the sums.
+    */
+    int n = c->numnodes;
+    if (numthreads < 1)
+        numthreads = 1;
+    if (n == 0)
+        return 0;
+
+    PagerankShared s;
+    s.g = c;
+    s.segments = build_segments(c, &s.numsegments);
+    s.rank = rank;
+    s.contrib = malloc(sizeof(double) * n);
+    s.sums = malloc(sizeof(double) * n);
+    s.jump = personalization;
+    s.damping = damping;
+    s.tolerance = tolerance;
+    s.maxiters = maxiters;
+    s.numthreads = numthreads;
+    s.dangling = calloc(numthreads, sizeof(double));
+    s.error = calloc(numthreads, sizeof(double));
+    s.iteration_seconds = iteration_seconds;
+    s.iterations = 0;
+    s.converged = false;
+    pthread_barrier_init(&s.barrier, NULL, numthreads);
+    for (int v = 0; v < n; v++)
+        rank[v] = personalization != NULL ? personalization[v] : 1.0 / n; // start from the jump distribution
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    PagerankTask *tasks = malloc(sizeof(PagerankTask) * numthreads);
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].shared = &s;
+        tasks[t].id = t;
+    }
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, pagerank_worker, &tasks[t]);
+    pagerank_worker(&tasks[0]); // the calling thread is worker 0
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    for (int k = 0; k < s.numsegments; k++)
+    {
+        free(s.segments[k].dests);
+        free(s.segments[k].offsets);
+        free(s.segments[k].sources);
+    }
+    free(s.segments);
+    free(s.contrib);
+    free(s.sums);
+    free(s.dangling);
+    free(s.error);
+    free(threads);
+    free(tasks);
+    pthread_barrier_destroy(&s.barrier);
+    return s.iterations;
+}
+
+#endif
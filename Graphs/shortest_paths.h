@@ -0,0 +1,313 @@
+// Single source shortest paths on a CSR graph (see csr.h)
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Two engines for the same problem, both working on the read-only CSR view so every edge scan is a sequential read:
+ *     - dijkstra: sequential, with a radix heap instead of a binary heap. Fastest for a single thread.
+ *     - delta_stepping: parallel, vertices are grouped in buckets of width delta and a whole bucket is relaxed by all threads at once.
+ * Both take non-negative integer weights (csr->weights, or 1 for every edge if the graph is unweighted) and return the distance of every vertex from the source, -1 if it can't be reached.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef SHORTEST_PATHS_H
+#define SHORTEST_PATHS_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "csr.h"
+
+void dijkstra(CsrPtr g, int source, long *dist, int *parent);                     // single source shortest paths with a radix heap
+void delta_stepping(CsrPtr g, int source, long *dist, long delta, int numthreads); // parallel single source shortest paths
+
+typedef struct int_vec
+{
+    int *data; // items
+    long size; // number of items
+    long cap;  // number of items that fit before the array has to grow
+} IntVec;
+
+static void int_vec_push(IntVec *vec, int val)
+{
+    if (vec->size == vec->cap)
+    {
+        vec->cap = vec->cap > 0 ? vec->cap * 2 : 16; // double the capacity, so pushing is O(1) amortized
+        vec->data = realloc(vec->data, sizeof(int) * vec->cap);
+    }
+    vec->data[vec->size++] = val;
+}
+
+/* A radix heap is a monotone priority queue: every key pushed must be >= the last key popped, which is always true in Dijkstra.
+ * Bucket i holds keys whose highest bit that differs from the last popped key is bit i - 1 (bucket 0 holds keys equal to it), so an entry only ever moves
+ * to lower buckets, at most 64 times in total, instead of being sifted up and down a binary heap. */
+#define RADIX_BUCKETS 65
+
+typedef struct radix_heap
+{
+    IntVec vertices[RADIX_BUCKETS]; // vertex of each entry, per bucket
+    long *keys[RADIX_BUCKETS];      // key of each entry, parallel to vertices
+    long last;                      // last key popped
+    long size;                      // total number of entries
+} RadixHeap;
+
+static int radix_bucket(long last, long key)
+{
+    return key == last ? 0 : 64 - __builtin_clzll((unsigned long)(key ^ last)); // position of the highest differing bit
+}
+
+static void radix_push(RadixHeap *h, long key, int vertex)
+{
+    int b = radix_bucket(h->last, key);
+    long cap = h->vertices[b].cap;
+    int_vec_push(&h->vertices[b], vertex);
+    if (h->vertices[b].cap != cap)
+        h->keys[b] = realloc(h->keys[b], sizeof(long) * h->vertices[b].cap); // keep the key array as big as the vertex array
+    h->keys[b][h->vertices[b].size - 1] = key;
+    h->size++;
+}
+
+static int radix_pop(RadixHeap *h, long *key)
+{
+    if (h->vertices[0].size == 0)
+    {
+        // find the first non-empty bucket and spread it over the lower buckets around its smallest key
+        int b = 1;
+        while (h->vertices[b].size == 0)
+            b++;
+        long min = h->keys[b][0];
+        for (long i = 1; i < h->vertices[b].size; i++)
+            if (h->keys[b][i] < min)
+                min = h->keys[b][i];
+        h->last = min;
+
+        long count = h->vertices[b].size;
+        h->vertices[b].size = 0;
+        h->size -= count; // radix_push adds them back
+        for (long i = 0; i < count; i++)
+            radix_push(h, h->keys[b][i], h->vertices[b].data[i]); // every entry lands in a bucket below b, so b's arrays are not touched
+    }
+
+    h->size--;
+    long i = --h->vertices[0].size;
+    *key = h->keys[0][i];
+    return h->vertices[0].data[i];
+}
+
+void dijkstra(CsrPtr g, int source, long *dist, int *parent)
+{
+    /*
+        Time Complexity: O(m + n * log(C)), where C is the largest distance, as each heap entry moves down the radix heap's buckets at most 64 times instead of paying O(log n) per heap operation.
+        Space Complexity: O(n + m), for the heap (a vertex is pushed once each time its distance improves).
+        Weights must not be negative. Unreachable vertices get distance -1 and parent -1.
+    */
+    RadixHeap h;
+    memset(&h, 0, sizeof(RadixHeap));
+
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        dist[i] = LONG_MAX; // not reached yet
+        parent[i] = -1;
+    }
+    dist[source] = 0;
+    parent[source] = source;
+    radix_push(&h, 0, source);
+
+    while (h.size > 0)
+    {
+        long d;
+        int u = radix_pop(&h, &d);
+        if (d > dist[u])
+            continue; // stale entry, u was already settled with a shorter distance
+
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            int v = g->targets[e];
+            long nd = d + (g->weights != NULL ? g->weights[e] : 1);
+            if (nd < dist[v])
+            {
+                dist[v] = nd; // shorter path to the neighbor through u
+                parent[v] = u;
+                radix_push(&h, nd, v);
+            }
+        }
+    }
+
+    for (int i = 0; i < g->numnodes; i++)
+        if (dist[i] == LONG_MAX)
+            dist[i] = -1; // -1 marks an unreached vertex, same as bfs
+
+    for (int b = 0; b < RADIX_BUCKETS; b++)
+    {
+        free(h.vertices[b].data);
+        free(h.keys[b]);
+    }
+}
+
+typedef struct sssp_shared
+{
+    CsrPtr g;                  // graph being searched
+    atomic_long *dist;         // tentative distances, lowered with CAS by every thread
+    long delta;                // width of a bucket
+    int numthreads;            // number of workers
+    pthread_barrier_t barrier; // workers meet here between two steps
+    IntVec frontier;           // vertices of the bucket processed in the current step
+    long bucket;               // index of the current bucket
+    IntVec **bins;             // bins[t][b] = vertices worker t put in bucket b
+    long *numbins;             // number of buckets allocated by each worker
+} SsspShared;
+
+typedef struct sssp_task
+{
+    SsspShared *shared; // state shared by all workers
+    int id;             // index of this worker
+} SsspTask;
+
+static void sssp_relax(SsspShared *s, int id, int u)
+{
+    long du = atomic_load_explicit(&s->dist[u], memory_order_relaxed);
+    if (du < s->delta * s->bucket)
+        return; // u was already settled in an earlier bucket with a shorter distance
+
+    for (long e = s->g->offsets[u]; e < s->g->offsets[u + 1]; e++)
+    {
+        int v = s->g->targets[e];
+        long nd = du + (s->g->weights != NULL ? s->g->weights[e] : 1);
+        long old = atomic_load_explicit(&s->dist[v], memory_order_relaxed);
+        while (nd < old)
+        {
+            if (atomic_compare_exchange_weak_explicit(&s->dist[v], &old, nd, memory_order_relaxed, memory_order_relaxed))
+            {
+                // improved the neighbor, queue it in this worker's own bin so no locking is needed
+                long b = nd / s->delta;
+                if (b >= s->numbins[id])
+                {
+                    long grown = b * 2 + 1;
+                    s->bins[id] = realloc(s->bins[id], sizeof(IntVec) * grown);
+                    memset(s->bins[id] + s->numbins[id], 0, sizeof(IntVec) * (grown - s->numbins[id]));
+                    s->numbins[id] = grown;
+                }
+                int_vec_push(&s->bins[id][b], v);
+                break;
+            }
+        }
+    }
+}
+
+static void *sssp_worker(void *arg)
+{
+    SsspTask *task = arg;
+    SsspShared *s = task->shared;
+    int id = task->id;
+
+    while (true)
+    {
+        // relax the edges of this worker's share of the current bucket
+        long lo = s->frontier.size * id / s->numthreads;
+        long hi = s->frontier.size * (id + 1) / s->numthreads;
+        for (long i = lo; i < hi; i++)
+            sssp_relax(s, id, s->frontier.data[i]);
+
+        pthread_barrier_wait(&s->barrier);
+
+        if (id == 0)
+        {
+            // pick the lowest non-empty bucket over all workers and gather it into the next frontier
+            long next = LONG_MAX;
+            for (int t = 0; t < s->numthreads; t++)
+                for (long b = s->bucket; b < s->numbins[t] && b < next; b++)
+                    if (s->bins[t][b].size > 0)
+                        next = b;
+
+            s->frontier.size = 0;
+            if (next != LONG_MAX)
+            {
+                s->bucket = next; // the same bucket again if relaxing it refilled it
+                for (int t = 0; t < s->numthreads; t++)
+                {
+                    if (next >= s->numbins[t])
+                        continue;
+                    IntVec *bin = &s->bins[t][next];
+                    for (long i = 0; i < bin->size; i++)
+                        int_vec_push(&s->frontier, bin->data[i]);
+                    bin->size = 0;
+                }
+            }
+        }
+
+        pthread_barrier_wait(&s->barrier);
+        if (s->frontier.size == 0)
+            return NULL; // every bucket is empty, all distances are final
+    }
+}
+
+void delta_stepping(CsrPtr g, int source, long *dist, long delta, int numthreads)
+{
+    /*
+        Time Complexity: O((n + m) / p) per step for p threads in the typical case. Vertices are processed in buckets of width delta: all the vertices of a bucket are relaxed in parallel,
+        and a bucket is revisited until relaxing it adds nothing new to it. A small delta behaves like Dijkstra (little wasted work, many steps), a large delta like Bellman-Ford (few steps, more re-relaxations).
+        Space Complexity: O(n + m), for the per-thread bins.
+        Weights must not be negative. If delta <= 0, the average edge weight is used. Unreachable vertices get distance -1.
+    */
+    if (numthreads < 1)
+        numthreads = 1;
+
+    if (delta <= 0)
+    {
+        long total = 0; // pick the average weight as the bucket width
+        for (long e = 0; e < g->numedges; e++)
+            total += g->weights != NULL ? g->weights[e] : 1;
+        delta = g->numedges > 0 && total / g->numedges > 0 ? total / g->numedges : 1;
+    }
+
+    SsspShared s;
+    memset(&s, 0, sizeof(SsspShared));
+    s.g = g;
+    s.delta = delta;
+    s.numthreads = numthreads;
+    s.dist = malloc(sizeof(atomic_long) * g->numnodes);
+    for (int i = 0; i < g->numnodes; i++)
+        atomic_init(&s.dist[i], LONG_MAX); // not reached yet
+    atomic_store(&s.dist[source], 0);
+    int_vec_push(&s.frontier, source); // the first step relaxes the source's edges
+    s.bins = calloc(numthreads, sizeof(IntVec *));
+    s.numbins = calloc(numthreads, sizeof(long));
+    pthread_barrier_init(&s.barrier, NULL, numthreads);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    SsspTask *tasks = malloc(sizeof(SsspTask) * numthreads);
+    for (int t = 0; t < numthreads; t++)
+    {
+        tasks[t].shared = &s;
+        tasks[t].id = t;
+    }
+    for (int t = 1; t < numthreads; t++)
+        pthread_create(&threads[t], NULL, sssp_worker, &tasks[t]);
+    sssp_worker(&tasks[0]); // the calling thread is worker 0
+    for (int t = 1; t < numthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        long d = atomic_load(&s.dist[i]);
+        dist[i] = d == LONG_MAX ? -1 : d; // -1 marks an unreached vertex, same as dijkstra
+    }
+
+    for (int t = 0; t < numthreads; t++)
+    {
+        for (long b = 0; b < s.numbins[t]; b++)
+            free(s.bins[t][b].data);
+        free(s.bins[t]);
+    }
+    pthread_barrier_destroy(&s.barrier);
+    free(s.bins);
+    free(s.numbins);
+    free(s.frontier.data);
+    free(s.dist);
+    free(threads);
+    free(tasks);
+}
+
+#endif
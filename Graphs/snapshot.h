@@ -0,0 +1,242 @@
+// Memory-mappable binary graph snapshots
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Saves a CSR graph (see csr.h) to a file that can be opened again with a single mmap: no parsing, no allocation, no copying.
+ * Queries run directly on the mapped pages, so opening a snapshot of any size takes about as long as opening a file, and every process that maps the same snapshot shares the same page cache.
+ * File layout (all integers little endian, each section starts on an 8 byte boundary):
+ *     header    SnapshotHeader, 64 bytes: magic "GRAPHSNP", version, number of vertices, number of neighbor entries, flags
+ *     offsets   (numnodes + 1) uint64_t, offsets into the neighbor array
+ *     neighbors numedges uint32_t, the neighbors of vertex v are neighbors[offsets[v]] ... neighbors[offsets[v + 1] - 1], sorted
+ *     weights   numedges uint32_t, only if SNAPSHOT_WEIGHTED is set in flags
+ * Neighbor lists are sorted when the snapshot is saved, so snapshot_has_edge is a binary search.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "csr.h"
+
+#define SNAPSHOT_MAGIC "GRAPHSNP" // first 8 bytes of a snapshot
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_WEIGHTED 1 // flag: a weight array follows the neighbor array
+
+typedef struct snapshot_header
+{
+    char magic[8];     // SNAPSHOT_MAGIC
+    uint32_t version;  // SNAPSHOT_VERSION
+    uint32_t flags;    // SNAPSHOT_WEIGHTED or 0
+    uint64_t numnodes; // number of vertices
+    uint64_t numedges; // number of neighbor entries
+    uint64_t reserved[4];
+} SnapshotHeader;
+
+typedef struct snapshot
+{
+    void *map;                 // start of the mapping
+    size_t size;               // length of the mapping
+    int numnodes;              // number of vertices
+    long numedges;             // number of neighbor entries
+    const uint64_t *offsets;   // points into the mapping
+    const uint32_t *neighbors; // points into the mapping
+    const uint32_t *weights;   // points into the mapping, NULL if the snapshot is unweighted
+} Snapshot;
+typedef Snapshot *SnapshotPtr;
+
+int save_snapshot(CsrPtr c, const char *path);                          // write c to path, 0 on success
+SnapshotPtr open_snapshot(const char *path);                            // map a snapshot read-only, NULL on failure
+void close_snapshot(SnapshotPtr s);                                     // unmap a snapshot
+bool snapshot_has_edge(SnapshotPtr s, int from_node, int to_node);      // check if there is an edge between two nodes
+long snapshot_degree(SnapshotPtr s, int v);                             // number of neighbors of v
+const uint32_t *snapshot_neighbors(SnapshotPtr s, int v, long *degree); // neighbors of v, in place in the mapping
+
+static int compare_neighbors(const void *a, const void *b)
+{
+    // (neighbor, weight) pairs packed in one uint64_t, ordered by neighbor
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t snapshot_align(size_t bytes)
+{
+    return (bytes + 7) & ~(size_t)7; // round up to a multiple of 8
+}
+
+int save_snapshot(CsrPtr c, const char *path)
+{
+    /*
+        Time Complexity: O(n + m log d), as every neighbor list is sorted before it is written (d is the largest degree).
+        Space Complexity: O(d), for sorting one list at a time.
+    */
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return -1;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(SnapshotHeader));
+    memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+    header.version = SNAPSHOT_VERSION;
+    header.flags = c->weights != NULL ? SNAPSHOT_WEIGHTED : 0;
+    header.numnodes = (uint64_t)c->numnodes;
+    header.numedges = (uint64_t)c->numedges;
+    fwrite(&header, sizeof(SnapshotHeader), 1, f);
+
+    for (int v = 0; v <= c->numnodes; v++)
+    {
+        uint64_t offset = (uint64_t)c->offsets[v];
+        fwrite(&offset, sizeof(uint64_t), 1, f);
+    }
+
+    // sort every list by neighbor, carrying its weights along, and write the two arrays
+    long maxdegree = 0;
+    for (int v = 0; v < c->numnodes; v++)
+        if (c->offsets[v + 1] - c->offsets[v] > maxdegree)
+            maxdegree = c->offsets[v + 1] - c->offsets[v];
+    uint64_t *pairs = malloc(sizeof(uint64_t) * (maxdegree > 0 ? maxdegree : 1));
+    uint32_t *sorted_weights = NULL;
+    if (c->weights != NULL)
+        sorted_weights = malloc(sizeof(uint32_t) * (c->numedges > 0 ? c->numedges : 1)); // written after all the neighbors
+
+    for (int v = 0; v < c->numnodes; v++)
+    {
+        long degree = c->offsets[v + 1] - c->offsets[v];
+        for (long i = 0; i < degree; i++)
+        {
+            long e = c->offsets[v] + i;
+            uint32_t weight = c->weights != NULL ? (uint32_t)c->weights[e] : 0;
+            pairs[i] = (uint64_t)(uint32_t)c->targets[e] << 32 | weight;
+        }
+        qsort(pairs, degree, sizeof(uint64_t), compare_neighbors);
+        for (long i = 0; i < degree; i++)
+        {
+            uint32_t neighbor = (uint32_t)(pairs[i] >> 32);
+            fwrite(&neighbor, sizeof(uint32_t), 1, f);
+            if (sorted_weights != NULL)
+                sorted_weights[c->offsets[v] + i] = (uint32_t)pairs[i];
+        }
+    }
+
+    static const char padding[8] = {0};
+    size_t neighbors_bytes = sizeof(uint32_t) * c->numedges;
+    fwrite(padding, 1, snapshot_align(neighbors_bytes) - neighbors_bytes, f); // keep the weights 8 byte aligned
+    if (sorted_weights != NULL)
+        fwrite(sorted_weights, sizeof(uint32_t), c->numedges, f);
+
+    free(pairs);
+    free(sorted_weights);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+SnapshotPtr open_snapshot(const char *path)
+{
+    /*
+        Time Complexity: O(1), only the header is read, pages of the arrays are loaded by the kernel the first time a query touches them.
+        Space Complexity: O(1), the arrays stay in the (shared) page cache.
+    */
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return NULL; // too small to be a snapshot
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const SnapshotHeader *header = map;
+    size_t body = (size_t)st.st_size - sizeof(SnapshotHeader);
+    size_t edge_bytes = (header->flags & SNAPSHOT_WEIGHTED) ? 2 * sizeof(uint32_t) : sizeof(uint32_t); // a neighbor, and a weight if there are weights
+    // every size is compared by division before it is multiplied, so a hostile header can't wrap around and pass
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, 8) != 0 || header->version != SNAPSHOT_VERSION ||
+        header->numnodes > INT_MAX || header->numnodes + 1 > body / sizeof(uint64_t) ||
+        header->numedges > (body - sizeof(uint64_t) * (header->numnodes + 1)) / edge_bytes)
+    {
+        munmap(map, st.st_size);
+        return NULL; // not a snapshot, or truncated
+    }
+    size_t offsets_bytes = sizeof(uint64_t) * (header->numnodes + 1);
+    size_t neighbors_bytes = snapshot_align(sizeof(uint32_t) * header->numedges);
+    size_t weights_bytes = (header->flags & SNAPSHOT_WEIGHTED) ? sizeof(uint32_t) * header->numedges : 0;
+    const uint64_t *offsets = (const uint64_t *)((const char *)map + sizeof(SnapshotHeader));
+    if (offsets_bytes + neighbors_bytes + weights_bytes > body || offsets[header->numnodes] != header->numedges)
+    {
+        munmap(map, st.st_size);
+        return NULL; // truncated (the neighbors are padded), or the last offset doesn't end the neighbors
+    }
+
+    SnapshotPtr s = malloc(sizeof(Snapshot));
+    s->map = map;
+    s->size = st.st_size;
+    s->numnodes = (int)header->numnodes;
+    s->numedges = (long)header->numedges;
+    s->offsets = offsets;
+    s->neighbors = (const uint32_t *)((const char *)s->offsets + offsets_bytes);
+    s->weights = weights_bytes > 0 ? (const uint32_t *)((const char *)s->neighbors + neighbors_bytes) : NULL;
+    return s;
+}
+
+void close_snapshot(SnapshotPtr s)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    munmap(s->map, s->size);
+    free(s);
+}
+
+long snapshot_degree(SnapshotPtr s, int v)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    return (long)(s->offsets[v + 1] - s->offsets[v]);
+}
+
+const uint32_t *snapshot_neighbors(SnapshotPtr s, int v, long *degree)
+{
+    /*
+        Time Complexity: O(1), the list is not copied.
+        Space Complexity: O(1)
+    */
+    *degree = snapshot_degree(s, v);
+    return s->neighbors + s->offsets[v];
+}
+
+bool snapshot_has_edge(SnapshotPtr s, int from_node, int to_node)
+{
+    /*
+        Time Complexity: O(log d), binary search in the sorted neighbor list of from_node.
+        Space Complexity: O(1)
+    */
+    uint64_t lo = s->offsets[from_node], hi = s->offsets[from_node + 1];
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (s->neighbors[mid] < (uint32_t)to_node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < s->offsets[from_node + 1] && s->neighbors[lo] == (uint32_t)to_node;
+}
+
+#endif
@@ -0,0 +1,481 @@
+// Half storage representations of undirected graphs in C: a packed triangular bit matrix and canonical adjacency lists
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * In an undirected graph the edge u - v is the same edge as v - u, but adj_list.c keeps a node for it in both lists and adj_matrix.c sets both cells.
+ * The two structures in this file store every edge exactly once, under its canonical pair (min(u, v), max(u, v)):
+ *     - TriMatrix: only the cells (lo, hi) with lo <= hi of the matrix, one bit each, n(n + 1) / 2 bits in total.
+ *       The cells are packed column by column (cell (lo, hi) is bit hi(hi + 1) / 2 + lo), so adding a vertex only appends one column at the end and nothing has to move.
+ *     - HalfList: the edge u - v is a single node in the list of min(u, v). has_edge and remove_edge only have to walk that one list.
+ *       The neighbors of v that are smaller than v live in other vertices' lists, so they are found through a reverse index (for every v, the vertices whose list holds v).
+ *       The reverse index is derived from the lists: it is built the first time get_neighbors needs it and thrown away by the next add_edge or remove_edge, so mutations never pay for it.
+ *       The cost moves to the queries instead: the first get_neighbors after any mutation rebuilds the whole index in O(n + m). That pays off when mutations come in batches between
+ *       rounds of neighbor queries. A workload that alternates single updates with get_neighbors calls rebuilds it every time, and is better served by adj_list.c.
+ * Both answer queries exactly like the full representations: has_edge(g, u, v) == has_edge(g, v, u), and get_neighbors returns every neighbor of a vertex.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct trimatrix
+{
+    int numnodes;   // number of nodes
+    uint64_t *bits; // cell (lo, hi) is bit hi * (hi + 1) / 2 + lo
+} TriMatrix;
+typedef TriMatrix *TriMatrixPtr;
+
+typedef struct node
+{
+    int data;          // the larger end of the edge
+    struct node *next; // pointer to the next node in the list
+} Node;
+typedef Node *NodePtr;
+
+typedef struct half_list
+{
+    int numnodes;         // number of nodes
+    NodePtr *adjlists;    // adjlists[u] holds every neighbor v > u (and u itself for a self loop)
+    int *degrees;         // full degree of every vertex, counting the edges stored in other lists
+    long numedges;        // number of edges, each stored once
+    long *rev_offsets;    // reverse index: the vertices whose list holds v are rev_sources[rev_offsets[v]] ... rev_sources[rev_offsets[v + 1] - 1]
+    int *rev_sources;     // NULL whenever the reverse index is out of date
+} HalfList;
+typedef HalfList *HalfListPtr;
+
+TriMatrixPtr create_tri_matrix(int numnodes);                          // create a graph
+void destroy_tri_matrix(TriMatrixPtr g);                               // destroy the graph
+void tri_add_edge(TriMatrixPtr g, int u, int v);                       // add an edge between two nodes
+void tri_remove_edge(TriMatrixPtr g, int u, int v);                    // remove an edge between two nodes
+bool tri_has_edge(TriMatrixPtr g, int u, int v);                       // check if there is an edge between two nodes
+void tri_add_vertex(TriMatrixPtr g);                                   // add a vertex
+int tri_get_neighbors(TriMatrixPtr g, int v, int *out);                // copy every neighbor of v into out, returns how many
+
+HalfListPtr create_half_list(int numnodes);                            // create a graph
+void destroy_half_list(HalfListPtr *g);                                // destroy the graph
+void half_add_edge(HalfListPtr g, int u, int v);                       // add an edge between two nodes
+void half_remove_edge(HalfListPtr g, int u, int v);                    // remove an edge between two nodes
+bool half_has_edge(HalfListPtr g, int u, int v);                       // check if there is an edge between two nodes
+void half_add_vertex(HalfListPtr g);                                   // add a vertex
+int half_get_neighbors(HalfListPtr g, int v, int *out);                // copy every neighbor of v into out (room for degrees[v]), returns how many
+void print_half_list(HalfListPtr g);                                   // print every vertex with all of its neighbors
+int undirected_benchmark(int numnodes, long numedges);                 // time and memory of both structures on a random graph
+
+#ifndef GRAPH_NO_MAIN
+int main(int argc, char **argv)
+{
+    // USAGE: ./undirected bench <numnodes> <numedges>
+    // example: gcc -O2 undirected.c -o undirected; ./undirected bench 20000 1000000
+    if (argc == 4 && strcmp(argv[1], "bench") == 0)
+        return undirected_benchmark(atoi(argv[2]), atol(argv[3]));
+
+    HalfListPtr g = create_half_list(8); // create a graph with 8 nodes
+    TriMatrixPtr m = create_tri_matrix(8);
+    int edges[][2] = {{0, 1}, {2, 0}, {1, 2}, {3, 1}, {2, 3}, {3, 4}, {5, 4}, {5, 6}, {6, 7}};
+    for (int i = 0; i < 9; i++)
+    {
+        half_add_edge(g, edges[i][0], edges[i][1]);
+        tri_add_edge(m, edges[i][0], edges[i][1]);
+    }
+
+    half_add_vertex(g);
+    tri_add_vertex(m);
+    half_add_edge(g, 8, 2);
+    tri_add_edge(m, 8, 2);
+    half_remove_edge(g, 1, 0); // either order of the two ends removes the same edge
+    tri_remove_edge(m, 1, 0);
+
+    printf("Is there an edge between %d and %d: %s / %s\n", 4, 5, half_has_edge(g, 4, 5) ? "true" : "false", tri_has_edge(m, 4, 5) ? "true" : "false");
+    printf("Is there an edge between %d and %d: %s / %s\n", 1, 0, half_has_edge(g, 1, 0) ? "true" : "false", tri_has_edge(m, 1, 0) ? "true" : "false");
+
+    print_half_list(g);
+    int neighbors[9];
+    int degree = tri_get_neighbors(m, 2, neighbors);
+    printf("Neighbors of 2 in the matrix | ");
+    for (int i = 0; i < degree; i++)
+        printf("%d ", neighbors[i]);
+    printf("\n");
+
+    destroy_tri_matrix(m);
+    destroy_half_list(&g); // destroy the graph, free the memory
+    return 0;
+}
+#endif
+
+static inline uint64_t tri_cell(int u, int v)
+{
+    // bit of the canonical pair (min, max)
+    uint64_t lo = u < v ? u : v, hi = u < v ? v : u;
+    return hi * (hi + 1) / 2 + lo;
+}
+
+static long tri_words(int numnodes)
+{
+    uint64_t cells = (uint64_t)numnodes * (numnodes + 1) / 2;
+    return (long)((cells + 63) / 64);
+}
+
+TriMatrixPtr create_tri_matrix(int numnodes)
+{
+    /*
+        Time Complexity: O(n^2 / 128), for clearing the bits.
+        Space Complexity: O(n^2 / 16) bytes, half of a bit matrix and a sixteenth of the bool matrix of adj_matrix.c.
+    */
+    TriMatrixPtr g = malloc(sizeof(TriMatrix));
+    if (g == NULL)
+        return NULL; // just in case malloc failed
+    g->numnodes = numnodes;
+    g->bits = calloc(tri_words(numnodes) > 0 ? tri_words(numnodes) : 1, sizeof(uint64_t));
+    if (g->bits == NULL)
+    {
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+void destroy_tri_matrix(TriMatrixPtr g)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    free(g->bits);
+    free(g);
+}
+
+void tri_add_edge(TriMatrixPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(1), one bit is set instead of two cells.
+        Space Complexity: O(1)
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+    uint64_t cell = tri_cell(u, v);
+    g->bits[cell >> 6] |= (uint64_t)1 << (cell & 63);
+}
+
+void tri_remove_edge(TriMatrixPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+    uint64_t cell = tri_cell(u, v);
+    g->bits[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+}
+
+bool tri_has_edge(TriMatrixPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+    uint64_t cell = tri_cell(u, v);
+    return (g->bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+void tri_add_vertex(TriMatrixPtr g)
+{
+    /*
+        Time Complexity: O(n / 64), the new column (lo, n) for every lo <= n is appended after the last one, so no existing bit moves.
+        Space Complexity: O(n / 64) words more, amortized by realloc.
+    */
+    long old_words = tri_words(g->numnodes);
+    g->numnodes++;
+    long words = tri_words(g->numnodes);
+    g->bits = realloc(g->bits, sizeof(uint64_t) * (words > 0 ? words : 1));
+    memset(g->bits + old_words, 0, sizeof(uint64_t) * (words - old_words)); // bits past the old last cell were already zero
+}
+
+int tri_get_neighbors(TriMatrixPtr g, int v, int *out)
+{
+    /*
+        Time Complexity: O(n), one bit test per vertex.
+        Space Complexity: O(1), out must have room for n neighbors.
+    */
+    int k = 0;
+    for (int u = 0; u < g->numnodes; u++)
+        if (tri_has_edge(g, u, v))
+            out[k++] = u;
+    return k;
+}
+
+HalfListPtr create_half_list(int numnodes)
+{
+    /*
+        Time Complexity: O(n), for the empty lists.
+        Space Complexity: O(n), for the lists and the degrees.
+    */
+    HalfListPtr g = malloc(sizeof(HalfList));
+    if (g == NULL)
+        return NULL; // just in case malloc failed
+    g->numnodes = numnodes;
+    g->numedges = 0;
+    g->adjlists = calloc(numnodes > 0 ? numnodes : 1, sizeof(NodePtr));
+    g->degrees = calloc(numnodes > 0 ? numnodes : 1, sizeof(int));
+    g->rev_offsets = NULL;
+    g->rev_sources = NULL;
+    return g;
+}
+
+static void drop_reverse_index(HalfListPtr g)
+{
+    // the lists changed, the next get_neighbors rebuilds the index
+    free(g->rev_offsets);
+    free(g->rev_sources);
+    g->rev_offsets = NULL;
+    g->rev_sources = NULL;
+}
+
+void destroy_half_list(HalfListPtr *g)
+{
+    /*
+        Time Complexity: O(n + m), every node is freed once, as every edge has one node.
+        Space Complexity: O(1)
+    */
+    for (int i = 0; i < (*g)->numnodes; i++)
+    {
+        NodePtr nu = (*g)->adjlists[i];
+        while (nu != NULL)
+        {
+            NodePtr next = nu->next;
+            free(nu);
+            nu = next;
+        }
+    }
+    drop_reverse_index(*g);
+    free((*g)->adjlists);
+    free((*g)->degrees);
+    free(*g);
+    *g = NULL;
+}
+
+void half_add_edge(HalfListPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(1), one node is allocated and linked, where adj_list.c allocates and links two.
+        Space Complexity: O(1), one node.
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+
+    int lo = u < v ? u : v, hi = u < v ? v : u;
+    NodePtr nu = malloc(sizeof(Node));
+    nu->data = hi;
+    nu->next = g->adjlists[lo]; // the edge lives in the list of its smaller end only
+    g->adjlists[lo] = nu;
+    g->degrees[lo]++;
+    if (hi != lo)
+        g->degrees[hi]++; // still a neighbor of hi, through the reverse index
+    g->numedges++;
+    drop_reverse_index(g);
+}
+
+void half_remove_edge(HalfListPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(d), only the list of min(u, v) is walked, where adj_list.c walks both lists.
+        Space Complexity: O(1)
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+
+    int lo = u < v ? u : v, hi = u < v ? v : u;
+    NodePtr nu = g->adjlists[lo];
+    NodePtr prev = NULL;
+    while (nu != NULL)
+    {
+        if (nu->data == hi)
+        {
+            if (prev == NULL)
+                g->adjlists[lo] = nu->next;
+            else
+                prev->next = nu->next;
+            free(nu);
+            g->degrees[lo]--;
+            if (hi != lo)
+                g->degrees[hi]--;
+            g->numedges--;
+            drop_reverse_index(g);
+            return;
+        }
+        prev = nu;
+        nu = nu->next;
+    }
+}
+
+bool half_has_edge(HalfListPtr g, int u, int v)
+{
+    /*
+        Time Complexity: O(d) for the list of min(u, v), which holds only the neighbors larger than it, so it is shorter than a full list.
+        Space Complexity: O(1)
+    */
+    assert(g != NULL);
+    assert(u >= 0 && u < g->numnodes);
+    assert(v >= 0 && v < g->numnodes);
+
+    int lo = u < v ? u : v, hi = u < v ? v : u;
+    for (NodePtr nu = g->adjlists[lo]; nu != NULL; nu = nu->next)
+        if (nu->data == hi)
+            return true; // edge exists
+    return false; // edge doesn't exist
+}
+
+void half_add_vertex(HalfListPtr g)
+{
+    /*
+        Time Complexity: O(n), for reallocating the lists and the degrees.
+        Space Complexity: O(1) more per vertex.
+    */
+    g->numnodes++;
+    g->adjlists = realloc(g->adjlists, sizeof(NodePtr) * g->numnodes);
+    g->degrees = realloc(g->degrees, sizeof(int) * g->numnodes);
+    g->adjlists[g->numnodes - 1] = NULL;
+    g->degrees[g->numnodes - 1] = 0;
+    drop_reverse_index(g); // the index has one offset per vertex
+}
+
+static void build_reverse_index(HalfListPtr g)
+{
+    // counting sort of every stored edge (lo, hi) by hi, so the vertices whose list holds v end up next to each other
+    g->rev_offsets = calloc(g->numnodes + 1, sizeof(long));
+    g->rev_sources = malloc(sizeof(int) * (g->numedges > 0 ? g->numedges : 1));
+    for (int u = 0; u < g->numnodes; u++)
+        for (NodePtr nu = g->adjlists[u]; nu != NULL; nu = nu->next)
+            if (nu->data != u)
+                g->rev_offsets[nu->data + 1]++; // a self loop is already in its own list
+    for (int v = 0; v < g->numnodes; v++)
+        g->rev_offsets[v + 1] += g->rev_offsets[v];
+
+    long *fill = malloc(sizeof(long) * (g->numnodes > 0 ? g->numnodes : 1));
+    memcpy(fill, g->rev_offsets, sizeof(long) * g->numnodes);
+    for (int u = 0; u < g->numnodes; u++)
+        for (NodePtr nu = g->adjlists[u]; nu != NULL; nu = nu->next)
+            if (nu->data != u)
+                g->rev_sources[fill[nu->data]++] = u;
+    free(fill);
+}
+
+int half_get_neighbors(HalfListPtr g, int v, int *out)
+{
+    /*
+        Time Complexity: O(d) while the reverse index is up to date, O(n + m) for the first call after a mutation, which rebuilds it (so every call, if updates and queries alternate).
+        Space Complexity: O(n + m) for the reverse index, kept until the next mutation. out must have room for the degree of v.
+    */
+    if (g->rev_sources == NULL)
+        build_reverse_index(g);
+
+    int k = 0;
+    for (long e = g->rev_offsets[v]; e < g->rev_offsets[v + 1]; e++)
+        out[k++] = g->rev_sources[e]; // smaller neighbors, stored in their lists
+    for (NodePtr nu = g->adjlists[v]; nu != NULL; nu = nu->next)
+        out[k++] = nu->data; // larger neighbors, stored in v's own list
+    return k;
+}
+
+void print_half_list(HalfListPtr g)
+{
+    /*
+        Time Complexity: O(n + m)
+        Space Complexity: O(max degree), for the neighbors of one vertex.
+    */
+    int maxdegree = 1;
+    for (int i = 0; i < g->numnodes; i++)
+        if (g->degrees[i] > maxdegree)
+            maxdegree = g->degrees[i]; // parallel edges are kept, so a degree can be larger than n
+    int *neighbors = malloc(sizeof(int) * maxdegree);
+    for (int i = 0; i < g->numnodes; i++)
+    {
+        int degree = half_get_neighbors(g, i, neighbors);
+        printf("Vertex %d | ", i);
+        for (int k = 0; k < degree; k++)
+            printf("%d -> ", neighbors[k]);
+        printf("NULL \n");
+    }
+    free(neighbors);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int undirected_benchmark(int numnodes, long numedges)
+{
+    /*
+        Time Complexity: O(q * d) for the q has_edge and remove_edge calls on the lists, O(m) for everything else.
+        Space Complexity: O(n^2 / 16) for the matrix, O(n + m) for the lists.
+    */
+    int *from = malloc(sizeof(int) * numedges);
+    int *to = malloc(sizeof(int) * numedges);
+    srand(42); // same graph on every run
+    for (long i = 0; i < numedges; i++)
+    {
+        from[i] = rand() % numnodes;
+        to[i] = rand() % numnodes;
+    }
+    long queries = numedges < 100000 ? numedges : 100000; // has_edge and remove_edge calls, the lists are too slow to query every edge
+    printf("vertices %d | edges %ld\n", numnodes, numedges);
+
+    TriMatrixPtr m = create_tri_matrix(numnodes);
+    double start = now_seconds();
+    for (long i = 0; i < numedges; i++)
+        tri_add_edge(m, from[i], to[i]);
+    double add_time = now_seconds() - start;
+    long hits = 0;
+    start = now_seconds();
+    for (long i = 0; i < queries; i++)
+        hits += tri_has_edge(m, to[i], from[i]); // reversed ends, every query must hit
+    double query_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < queries; i++)
+        tri_remove_edge(m, from[i], to[i]);
+    double remove_time = now_seconds() - start;
+    printf("triangular matrix | %.1f MB, full bit matrix %.1f MB, bool matrix %.1f MB | add %.3f s | %ld has_edge %.3f s, remove %.3f s\n",
+           tri_words(numnodes) * 8 / 1e6, (double)numnodes * numnodes / 8 / 1e6, (double)numnodes * numnodes / 1e6, add_time, queries, query_time, remove_time);
+    destroy_tri_matrix(m);
+    bool match = hits == queries;
+
+    HalfListPtr g = create_half_list(numnodes);
+    start = now_seconds();
+    for (long i = 0; i < numedges; i++)
+        half_add_edge(g, from[i], to[i]);
+    add_time = now_seconds() - start;
+    hits = 0;
+    start = now_seconds();
+    for (long i = 0; i < queries; i++)
+        hits += half_has_edge(g, to[i], from[i]);
+    query_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < queries; i++)
+        half_remove_edge(g, from[i], to[i]);
+    remove_time = now_seconds() - start;
+    printf("half list         | %.1f MB of nodes, full lists %.1f MB | add %.3f s | %ld has_edge %.3f s, remove %.3f s\n",
+           numedges * sizeof(Node) / 1e6, 2 * numedges * sizeof(Node) / 1e6, add_time, queries, query_time, remove_time);
+    destroy_half_list(&g);
+    match = match && hits == queries;
+
+    free(from);
+    free(to);
+    printf("every edge found from both ends: %s\n", match ? "true" : "false");
+    return match ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Benchmark of the red-black tree (main.c) against the B+-tree (bptree.h)
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * Runs the same operations on both trees, for three workloads:
+ *     random: random keys, looked up in a different random order
+ *     sequential: keys 0, 1, 2, ... inserted, looked up and deleted in increasing order
+ *     skewed: random keys, but the lookups favor a few of them: lookup i is for key number count * u^4 (u uniform in [0, 1)), so over half of the lookups hit 10% of the keys
+ * and times insert, search, scan (the 100 keys from a looked up key onwards) and delete.
+ * Results are printed as one JSON object per line, like the graph benchmark:
+ *     {"structure": "bptree", "workload": "random", "keys": 1000000, "operation": "search", "count": 1000000, "seconds": 0.21, "ops_per_sec": 4761904}
+ * The last line of every run reports the bytes held per key by the tree once every key is in.
+ *
+ * USAGE: ./bench <number of keys>
+ */
+#define RB_NO_MAIN
+#include "main.c"
+#include "bptree.h"
+
+#define SCAN_LENGTH 100 // keys copied by every scan
+
+static void report(const char *structure, const char *workload, int count, const char *operation, long ops, double seconds)
+{
+    printf("{\"structure\": \"%s\", \"workload\": \"%s\", \"keys\": %d, \"operation\": \"%s\", \"count\": %ld, \"seconds\": %.6f, \"ops_per_sec\": %.0f}\n",
+           structure, workload, count, operation, ops, seconds, seconds > 0 ? ops / seconds : 0);
+}
+
+static void report_bytes(const char *structure, const char *workload, int count, long bytes)
+{
+    printf("{\"structure\": \"%s\", \"workload\": \"%s\", \"keys\": %d, \"bytes_per_key\": %.2f}\n", structure, workload, count, (double)bytes / count);
+}
+
+static void bench_rbtree(const char *workload, const int *keys, const int *queries, int count)
+{
+    struct timespec start;
+    int *scanned = malloc(sizeof(int) * SCAN_LENGTH);
+    RbTreePtr t = rb_create(0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_insert(t, keys[i]);
+    report("rbtree", workload, count, "insert", count, seconds_since(start));
+
+    long found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += rb_search(t, queries[i]) != NILL;
+    report("rbtree", workload, count, "search", count, seconds_since(start));
+    if (found != count)
+        printf("rbtree: only %ld of %d keys found\n", found, count);
+
+    int numscans = count / SCAN_LENGTH;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numscans; i++)
+        found += rb_range_fill(t, queries[i], INT_MAX, scanned, SCAN_LENGTH);
+    report("rbtree", workload, count, "scan", numscans, seconds_since(start));
+    long bytes = sizeof(RbTree) + sizeof(Node) * (long)t->capacity;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_delete(t, keys[i]);
+    report("rbtree", workload, count, "delete", count, seconds_since(start));
+    report_bytes("rbtree", workload, count, bytes);
+
+    destroy_bst(&t);
+    free(scanned);
+}
+
+static void bench_bptree(const char *workload, const int *keys, const int *queries, int count)
+{
+    struct timespec start;
+    int *scanned = malloc(sizeof(int) * SCAN_LENGTH);
+    BptTreePtr t = bpt_create();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        bpt_insert(t, keys[i]);
+    report("bptree", workload, count, "insert", count, seconds_since(start));
+
+    long found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += bpt_search(t, queries[i]);
+    report("bptree", workload, count, "search", count, seconds_since(start));
+    if (found != count)
+        printf("bptree: only %ld of %d keys found\n", found, count);
+
+    int numscans = count / SCAN_LENGTH;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numscans; i++)
+        found += bpt_range_fill(t, queries[i], INT_MAX, scanned, SCAN_LENGTH);
+    report("bptree", workload, count, "scan", numscans, seconds_since(start));
+    long bytes = bpt_bytes(t);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        bpt_delete(t, keys[i]);
+    report("bptree", workload, count, "delete", count, seconds_since(start));
+    report_bytes("bptree", workload, count, bytes);
+
+    destroy_bpt(&t);
+    free(scanned);
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    // xorshift64, rand() only has 31 bits on some platforms and 15 on others
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc == 2 ? atoi(argv[1]) : 0;
+    if (count < 1)
+    {
+        printf("USAGE: ./bench <number of keys>\n");
+        return 1;
+    }
+    int *keys = malloc(sizeof(int) * count);
+    int *queries = malloc(sizeof(int) * count);
+    if (keys == NULL || queries == NULL)
+    {
+        printf("Not enough memory for %d keys\n", count);
+        free(keys);
+        free(queries);
+        return 1;
+    }
+    uint64_t state = 42;
+
+    // random
+    for (int i = 0; i < count; i++)
+        keys[i] = (int)(next_random(&state) >> 33);
+    for (int i = 0; i < count; i++)
+        queries[i] = keys[i];
+    for (int i = count - 1; i > 0; i--)
+    {
+        int j = (int)(next_random(&state) % (i + 1)); // Fisher-Yates shuffle
+        int tmp = queries[i];
+        queries[i] = queries[j];
+        queries[j] = tmp;
+    }
+    bench_rbtree("random", keys, queries, count);
+    bench_bptree("random", keys, queries, count);
+
+    // sequential
+    for (int i = 0; i < count; i++)
+        keys[i] = queries[i] = i;
+    bench_rbtree("sequential", keys, queries, count);
+    bench_bptree("sequential", keys, queries, count);
+
+    // skewed
+    for (int i = 0; i < count; i++)
+        keys[i] = (int)(next_random(&state) >> 33);
+    for (int i = 0; i < count; i++)
+    {
+        double u = (next_random(&state) >> 11) / 9007199254740992.0; // 53 random bits in [0, 1)
+        queries[i] = keys[(int)(count * (u * u * u * u))];
+    }
+    bench_rbtree("skewed", keys, queries, count);
+    bench_bptree("skewed", keys, queries, count);
+
+    free(keys);
+    free(queries);
+    return 0;
+}
@@ -0,0 +1,495 @@
+// B+-tree of int keys, an alternative to the red-black tree in main.c with the same insert / delete / search API
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * A red-black tree node holds one key, so a search reads one node, and usually misses the cache once, per level: about log2(n) levels.
+ * A B+-tree node is a few whole cache lines (BPT_NODE_LINES) holding many keys, so a search reads log_B(n) nodes instead, with B around 30:
+ *     inner nodes hold up to BPT_INNER_KEYS separator keys and one more child; child i holds the keys between keys[i - 1] and keys[i]
+ *     leaves hold up to BPT_LEAF_KEYS keys, and are linked to the next leaf, so a range scan reads the leaves front to back without going back up the tree
+ * Unused key slots hold INT_MAX, so finding a key's position in a node is a count of the keys smaller than it over the whole, fixed size, aligned key array:
+ * a loop without branches that the compiler turns into SIMD compares (with -O3 -march=native), without platform specific intrinsics.
+ * Like the red-black tree, nodes live in one pool and refer to each other by 32-bit index, and the tree keeps duplicate keys.
+ * Every node except the root is at least half full: inserts split full nodes, deletes borrow a key from a sibling or merge with it.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef BPTREE_H
+#define BPTREE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#define BPT_LINE 64 // bytes per cache line
+#ifndef BPT_NODE_LINES
+#define BPT_NODE_LINES 4 // cache lines per node: with 4, a node holds 62 keys (leaf) or 31 keys and 32 children (inner)
+#endif
+#define BPT_NODE_BYTES (BPT_LINE * BPT_NODE_LINES)
+#define BPT_LEAF_KEYS ((BPT_NODE_BYTES - 8) / 4)  // keys, count and next leaf
+#define BPT_INNER_KEYS ((BPT_NODE_BYTES - 8) / 8) // keys, count and one more child than keys
+#define BPT_MIN_LEAF_KEYS (BPT_LEAF_KEYS / 2)     // keys of every leaf except the root
+#define BPT_MIN_INNER_KEYS (BPT_INNER_KEYS / 2)   // keys of every inner node except the root
+#define BPT_NONE 0                                // index of no node, the first node of the pool is never used
+#define BPT_MAX_HEIGHT 32                         // inner levels, far more than 2^31 nodes can fill
+
+typedef struct bpt_leaf
+{
+    int keys[BPT_LEAF_KEYS]; // keys[0 .. count - 1] in increasing order, then INT_MAX
+    int count;               // number of keys
+    uint32_t next;           // next leaf in key order, BPT_NONE for the last one
+} BptLeaf;
+
+typedef struct bpt_inner
+{
+    int keys[BPT_INNER_KEYS];             // separators in increasing order, then INT_MAX
+    int count;                            // number of separators, the node has count + 1 children
+    uint32_t children[BPT_INNER_KEYS + 1]; // keys in children[i] are >= keys[i - 1] and <= keys[i]
+} BptInner;
+
+typedef union bpt_node
+{
+    BptLeaf leaf;
+    BptInner inner;
+    _Alignas(BPT_LINE) char bytes[BPT_NODE_BYTES]; // every node starts on a cache line and fills whole lines
+} BptNode;
+
+typedef struct bpt_tree
+{
+    BptNode *nodes;    // every node of the tree, aligned to a cache line
+    uint32_t capacity; // number of nodes allocated
+    uint32_t used;     // nodes handed out at least once, including BPT_NONE
+    uint32_t free;     // most recently released node, released nodes are chained through leaf.next
+    uint32_t root;     // a leaf when height is 0
+    int height;        // number of inner levels above the leaves
+    long count;        // number of keys
+} BptTree;
+typedef BptTree *BptTreePtr;
+
+BptTreePtr bpt_create(void);                                           // create an empty tree
+void bpt_insert(BptTreePtr t, int key);                                // insert key
+void bpt_delete(BptTreePtr t, int key);                                // delete one copy of key, if there is one
+bool bpt_search(BptTreePtr t, int key);                                // whether key is in the tree
+long bpt_range_fill(BptTreePtr t, int lo, int hi, int *keys, long max); // copy the first (at most max) keys in [lo, hi] to keys, returns how many were copied
+long bpt_bytes(BptTreePtr t);                                          // memory held by the tree
+void destroy_bpt(BptTreePtr *treePtr);                                 // destroy the tree
+
+static inline BptLeaf *bpt_leaf(BptTreePtr t, uint32_t x)
+{
+    // only valid until the next bpt_alloc, which may move the pool
+    return &t->nodes[x].leaf;
+}
+
+static inline BptInner *bpt_inner(BptTreePtr t, uint32_t x)
+{
+    return &t->nodes[x].inner;
+}
+
+static inline int bpt_position(const int *keys, int capacity, int key)
+{
+    // number of keys smaller than key, the INT_MAX padding is never counted. capacity is a constant at every call, so the loop has a fixed trip count
+    keys = __builtin_assume_aligned(keys, BPT_LINE);
+    int pos = 0;
+    for (int i = 0; i < capacity; i++)
+        pos += keys[i] < key;
+    return pos;
+}
+
+static uint32_t bpt_alloc(BptTreePtr t, bool leaf)
+{
+    // take an empty node from the pool, the pool doubles when it is full
+    uint32_t x;
+    if (t->free != BPT_NONE)
+    {
+        x = t->free;
+        t->free = t->nodes[x].leaf.next;
+    }
+    else
+    {
+        if (t->used == t->capacity)
+        {
+            // aligned_alloc has no realloc, so the nodes are copied by hand; they refer to each other by index, so moving them is fine
+            uint32_t capacity = t->capacity * 2;
+            BptNode *nodes = aligned_alloc(BPT_LINE, sizeof(BptNode) * capacity);
+            memcpy(nodes, t->nodes, sizeof(BptNode) * t->used);
+            free(t->nodes);
+            t->nodes = nodes;
+            t->capacity = capacity;
+        }
+        x = t->used++;
+    }
+
+    if (leaf)
+    {
+        BptLeaf *l = bpt_leaf(t, x);
+        for (int i = 0; i < BPT_LEAF_KEYS; i++)
+            l->keys[i] = INT_MAX;
+        l->count = 0;
+        l->next = BPT_NONE;
+    }
+    else
+    {
+        BptInner *in = bpt_inner(t, x);
+        for (int i = 0; i < BPT_INNER_KEYS; i++)
+            in->keys[i] = INT_MAX;
+        in->count = 0;
+        for (int i = 0; i <= BPT_INNER_KEYS; i++)
+            in->children[i] = BPT_NONE;
+    }
+    return x;
+}
+
+static void bpt_release(BptTreePtr t, uint32_t x)
+{
+    t->nodes[x].leaf.next = t->free;
+    t->free = x;
+}
+
+BptTreePtr bpt_create(void)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    BptTreePtr t = malloc(sizeof(BptTree));
+    t->capacity = 16;
+    t->nodes = aligned_alloc(BPT_LINE, sizeof(BptNode) * t->capacity);
+    t->used = 1; // node 0 is BPT_NONE
+    t->free = BPT_NONE;
+    t->height = 0;
+    t->count = 0;
+    t->root = bpt_alloc(t, true); // an empty leaf
+    return t;
+}
+
+static uint32_t bpt_descend(BptTreePtr t, int key, uint32_t *path, int *slots)
+{
+    // go down to the first leaf that can hold key, remembering the inner nodes on the way (path) and which child was taken in each (slots)
+    uint32_t x = t->root;
+    for (int level = 0; level < t->height; level++)
+    {
+        BptInner *in = bpt_inner(t, x);
+        int pos = bpt_position(in->keys, BPT_INNER_KEYS, key); // first child whose keys can be >= key
+        if (path != NULL)
+        {
+            path[level] = x;
+            slots[level] = pos;
+        }
+        x = in->children[pos];
+    }
+    return x;
+}
+
+bool bpt_search(BptTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log_B(n)) nodes read, for B keys per node
+        Space Complexity: O(1)
+    */
+    BptLeaf *l = bpt_leaf(t, bpt_descend(t, key, NULL, NULL));
+    int pos = bpt_position(l->keys, BPT_LEAF_KEYS, key);
+    if (pos < l->count)
+        return l->keys[pos] == key;
+    // every key of the leaf is smaller: when the separator above equals key, its first copy starts the next leaf
+    return l->next != BPT_NONE && bpt_leaf(t, l->next)->keys[0] == key;
+}
+
+void bpt_insert(BptTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log_B(n) * B), a split copies a node
+        Space Complexity: O(B)
+    */
+    uint32_t path[BPT_MAX_HEIGHT];
+    int slots[BPT_MAX_HEIGHT];
+    uint32_t x = bpt_descend(t, key, path, slots);
+    t->count++;
+
+    BptLeaf *l = bpt_leaf(t, x);
+    int pos = bpt_position(l->keys, BPT_LEAF_KEYS, key);
+    if (l->count < BPT_LEAF_KEYS)
+    {
+        memmove(&l->keys[pos + 1], &l->keys[pos], sizeof(int) * (l->count - pos)); // the padding slot after the last key is overwritten
+        l->keys[pos] = key;
+        l->count++;
+        return;
+    }
+
+    // the leaf is full: split its keys and key into two leaves, the smaller half stays
+    int all[BPT_LEAF_KEYS + 1];
+    memcpy(all, l->keys, sizeof(int) * pos);
+    all[pos] = key;
+    memcpy(all + pos + 1, l->keys + pos, sizeof(int) * (BPT_LEAF_KEYS - pos));
+    uint32_t r = bpt_alloc(t, true);
+    l = bpt_leaf(t, x);
+    BptLeaf *right = bpt_leaf(t, r);
+    int keep = (BPT_LEAF_KEYS + 1) / 2;
+    memcpy(l->keys, all, sizeof(int) * keep);
+    for (int i = keep; i < BPT_LEAF_KEYS; i++)
+        l->keys[i] = INT_MAX;
+    l->count = keep;
+    memcpy(right->keys, all + keep, sizeof(int) * (BPT_LEAF_KEYS + 1 - keep));
+    right->count = BPT_LEAF_KEYS + 1 - keep;
+    right->next = l->next;
+    l->next = r;
+
+    // add the new leaf to the parent, splitting full inner nodes up the path
+    int separator = right->keys[0];
+    uint32_t child = r;
+    for (int level = t->height - 1; level >= 0; level--)
+    {
+        uint32_t p = path[level];
+        int s = slots[level]; // the split node is children[s], the new node goes right after it
+        BptInner *in = bpt_inner(t, p);
+        if (in->count < BPT_INNER_KEYS)
+        {
+            memmove(&in->keys[s + 1], &in->keys[s], sizeof(int) * (in->count - s));
+            memmove(&in->children[s + 2], &in->children[s + 1], sizeof(uint32_t) * (in->count - s));
+            in->keys[s] = separator;
+            in->children[s + 1] = child;
+            in->count++;
+            return;
+        }
+
+        int keys[BPT_INNER_KEYS + 1];
+        uint32_t children[BPT_INNER_KEYS + 2];
+        memcpy(keys, in->keys, sizeof(int) * s);
+        keys[s] = separator;
+        memcpy(keys + s + 1, in->keys + s, sizeof(int) * (BPT_INNER_KEYS - s));
+        memcpy(children, in->children, sizeof(uint32_t) * (s + 1));
+        children[s + 1] = child;
+        memcpy(children + s + 2, in->children + s + 1, sizeof(uint32_t) * (BPT_INNER_KEYS - s));
+
+        // the middle key moves up, it separates the two halves
+        uint32_t n = bpt_alloc(t, false);
+        in = bpt_inner(t, p);
+        BptInner *split = bpt_inner(t, n);
+        int mid = (BPT_INNER_KEYS + 1) / 2;
+        memcpy(in->keys, keys, sizeof(int) * mid);
+        for (int i = mid; i < BPT_INNER_KEYS; i++)
+            in->keys[i] = INT_MAX;
+        memcpy(in->children, children, sizeof(uint32_t) * (mid + 1));
+        for (int i = mid + 1; i <= BPT_INNER_KEYS; i++)
+            in->children[i] = BPT_NONE;
+        in->count = mid;
+        split->count = BPT_INNER_KEYS - mid;
+        memcpy(split->keys, keys + mid + 1, sizeof(int) * split->count);
+        memcpy(split->children, children + mid + 1, sizeof(uint32_t) * (split->count + 1));
+        separator = keys[mid];
+        child = n;
+    }
+
+    // the root was split, the tree grows by one level
+    uint32_t root = bpt_alloc(t, false);
+    BptInner *in = bpt_inner(t, root);
+    in->keys[0] = separator;
+    in->children[0] = t->root;
+    in->children[1] = child;
+    in->count = 1;
+    t->root = root;
+    t->height++;
+}
+
+static void bpt_remove_child(BptTreePtr t, uint32_t p, int k)
+{
+    // remove keys[k] and children[k + 1] from inner node p, after children[k + 1] was merged into children[k]
+    BptInner *in = bpt_inner(t, p);
+    memmove(&in->keys[k], &in->keys[k + 1], sizeof(int) * (in->count - k - 1));
+    memmove(&in->children[k + 1], &in->children[k + 2], sizeof(uint32_t) * (in->count - k - 1));
+    in->count--;
+    in->keys[in->count] = INT_MAX;
+    in->children[in->count + 1] = BPT_NONE;
+}
+
+static void bpt_fix_leaf(BptTreePtr t, uint32_t x, uint32_t p, int s)
+{
+    // leaf x = children[s] of p has one key too few: borrow a key from a sibling, or merge with it
+    BptInner *in = bpt_inner(t, p);
+    BptLeaf *l = bpt_leaf(t, x);
+    if (s > 0)
+    {
+        BptLeaf *left = bpt_leaf(t, in->children[s - 1]);
+        if (left->count > BPT_MIN_LEAF_KEYS)
+        {
+            memmove(&l->keys[1], &l->keys[0], sizeof(int) * l->count);
+            l->keys[0] = left->keys[--left->count];
+            left->keys[left->count] = INT_MAX;
+            l->count++;
+            in->keys[s - 1] = l->keys[0]; // everything on the left is still <= the separator
+            return;
+        }
+        memcpy(&left->keys[left->count], l->keys, sizeof(int) * l->count);
+        left->count += l->count;
+        left->next = l->next;
+        bpt_release(t, x);
+        bpt_remove_child(t, p, s - 1);
+        return;
+    }
+
+    uint32_t r = in->children[1];
+    BptLeaf *right = bpt_leaf(t, r);
+    if (right->count > BPT_MIN_LEAF_KEYS)
+    {
+        l->keys[l->count++] = right->keys[0];
+        memmove(&right->keys[0], &right->keys[1], sizeof(int) * (right->count - 1));
+        right->keys[--right->count] = INT_MAX;
+        in->keys[0] = right->keys[0];
+        return;
+    }
+    memcpy(&l->keys[l->count], right->keys, sizeof(int) * right->count);
+    l->count += right->count;
+    l->next = right->next;
+    bpt_release(t, r);
+    bpt_remove_child(t, p, 0);
+}
+
+static void bpt_fix_inner(BptTreePtr t, uint32_t x, uint32_t p, int s)
+{
+    // inner node x = children[s] of p has one key too few: rotate a key through the parent from a sibling, or merge with it around the parent's key
+    BptInner *in = bpt_inner(t, p);
+    BptInner *node = bpt_inner(t, x);
+    if (s > 0)
+    {
+        BptInner *left = bpt_inner(t, in->children[s - 1]);
+        if (left->count > BPT_MIN_INNER_KEYS)
+        {
+            memmove(&node->keys[1], &node->keys[0], sizeof(int) * node->count);
+            memmove(&node->children[1], &node->children[0], sizeof(uint32_t) * (node->count + 1));
+            node->keys[0] = in->keys[s - 1];
+            node->children[0] = left->children[left->count];
+            node->count++;
+            in->keys[s - 1] = left->keys[left->count - 1];
+            left->keys[left->count - 1] = INT_MAX;
+            left->children[left->count] = BPT_NONE;
+            left->count--;
+            return;
+        }
+        left->keys[left->count] = in->keys[s - 1];
+        memcpy(&left->keys[left->count + 1], node->keys, sizeof(int) * node->count);
+        memcpy(&left->children[left->count + 1], node->children, sizeof(uint32_t) * (node->count + 1));
+        left->count += 1 + node->count;
+        bpt_release(t, x);
+        bpt_remove_child(t, p, s - 1);
+        return;
+    }
+
+    uint32_t r = in->children[1];
+    BptInner *right = bpt_inner(t, r);
+    if (right->count > BPT_MIN_INNER_KEYS)
+    {
+        node->keys[node->count] = in->keys[0];
+        node->children[node->count + 1] = right->children[0];
+        node->count++;
+        in->keys[0] = right->keys[0];
+        memmove(&right->keys[0], &right->keys[1], sizeof(int) * (right->count - 1));
+        memmove(&right->children[0], &right->children[1], sizeof(uint32_t) * right->count);
+        right->count--;
+        right->keys[right->count] = INT_MAX;
+        right->children[right->count + 1] = BPT_NONE;
+        return;
+    }
+    node->keys[node->count] = in->keys[0];
+    memcpy(&node->keys[node->count + 1], right->keys, sizeof(int) * right->count);
+    memcpy(&node->children[node->count + 1], right->children, sizeof(uint32_t) * (right->count + 1));
+    node->count += 1 + right->count;
+    bpt_release(t, r);
+    bpt_remove_child(t, p, 0);
+}
+
+void bpt_delete(BptTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log_B(n) * B), a merge copies a node
+        Space Complexity: O(1)
+    */
+    uint32_t path[BPT_MAX_HEIGHT];
+    int slots[BPT_MAX_HEIGHT];
+    uint32_t x = bpt_descend(t, key, path, slots);
+    BptLeaf *l = bpt_leaf(t, x);
+    int pos = bpt_position(l->keys, BPT_LEAF_KEYS, key);
+    if (pos == l->count)
+    {
+        // every key of the leaf is smaller, so the first copy of key can only be the first key of the next leaf: move the path there
+        int level = t->height - 1;
+        while (level >= 0 && slots[level] == bpt_inner(t, path[level])->count)
+            level--;
+        if (level < 0)
+            return; // key is larger than every key of the tree
+        slots[level]++;
+        x = bpt_inner(t, path[level])->children[slots[level]];
+        for (level++; level < t->height; level++)
+        {
+            path[level] = x;
+            slots[level] = 0;
+            x = bpt_inner(t, x)->children[0];
+        }
+        l = bpt_leaf(t, x);
+        pos = 0;
+    }
+    if (l->count == 0 || l->keys[pos] != key)
+        return; // key is not in the tree
+
+    memmove(&l->keys[pos], &l->keys[pos + 1], sizeof(int) * (l->count - pos - 1));
+    l->keys[--l->count] = INT_MAX;
+    t->count--;
+    if (t->height == 0 || l->count >= BPT_MIN_LEAF_KEYS)
+        return;
+
+    // fix the underfull node, which can make its parent underfull in turn
+    bpt_fix_leaf(t, x, path[t->height - 1], slots[t->height - 1]);
+    for (int level = t->height - 1; level > 0; level--)
+    {
+        if (bpt_inner(t, path[level])->count >= BPT_MIN_INNER_KEYS)
+            return;
+        bpt_fix_inner(t, path[level], path[level - 1], slots[level - 1]);
+    }
+    if (bpt_inner(t, t->root)->count == 0)
+    {
+        // the root lost its last separator, its only child becomes the root
+        uint32_t old = t->root;
+        t->root = bpt_inner(t, old)->children[0];
+        t->height--;
+        bpt_release(t, old);
+    }
+}
+
+long bpt_range_fill(BptTreePtr t, int lo, int hi, int *keys, long max)
+{
+    /*
+        Time Complexity: O(log_B(n) + k / B) nodes read for the k keys copied
+        Space Complexity: O(1)
+    */
+    long count = 0;
+    uint32_t x = bpt_descend(t, lo, NULL, NULL);
+    int pos = bpt_position(bpt_leaf(t, x)->keys, BPT_LEAF_KEYS, lo);
+    while (x != BPT_NONE && count < max)
+    {
+        BptLeaf *l = bpt_leaf(t, x);
+        for (; pos < l->count && count < max; pos++)
+        {
+            if (l->keys[pos] > hi)
+                return count;
+            keys[count++] = l->keys[pos];
+        }
+        x = l->next; // the linked leaves, no need to go back up
+        pos = 0;
+    }
+    return count;
+}
+
+long bpt_bytes(BptTreePtr t)
+{
+    return sizeof(BptTree) + sizeof(BptNode) * (long)t->capacity;
+}
+
+void destroy_bpt(BptTreePtr *treePtr)
+{
+    // destroy the tree and free memory, every node is in the pool
+    free((*treePtr)->nodes);
+    free(*treePtr);
+    *treePtr = NULL;
+}
+
+#endif
@@ -0,0 +1,829 @@
+// Concurrent red-black tree in C: optimistic lock-free reads validated by a seqlock, with epoch based reclamation
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * The tree in main.c has no synchronization, so sharing it between threads means one lock around every search and every update,
+ * and readers then wait for each other as well as for writers. Here readers never take a lock and never write to memory another thread reads:
+ *     - Writers are serialized by a mutex, and every change to the tree's shape happens between two increments of a sequence counter (a seqlock):
+ *       the counter is odd while the tree is being changed. A writer only opens this window once it has found where to insert or what to delete,
+ *       so the window covers the relinking and the recoloring / rotations, not the descent.
+ *     - A reader notes the counter, descends without any lock (every child link is an atomic load), and checks the counter again at the end.
+ *       If it changed, a writer may have rotated nodes under the reader, so the reader tries again. A reader that arrives while the counter is odd
+ *       spins until the writer is done, which does not count as an attempt. After CRB_MAX_ATTEMPTS failed validations
+ *       (only possible while writes keep coming back to back) the reader takes the writer's mutex once, so it always finishes.
+ *     - A reader in the middle of a rotation can follow links that are briefly inconsistent, even a cycle, so every walk is bounded and retried when it runs too long.
+ *     - A deleted node can still be in use by a reader that has not validated yet, so it is retired and freed by epoch based reclamation (like ../Graphs/concurrent.c):
+ *       a global epoch only advances once every active reader has seen the current one, so anything retired in epoch e is unreachable by every reader once the epoch reaches e + 2.
+ * Keys never change once a node is published, and only writers read parent pointers and colors, so those are plain fields.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#define BLACK 0
+#define RED 1
+#define MAX_READERS 64     // reader threads that can be registered at the same time
+#define READER_IDLE 0      // slot state of a reader outside a read
+#define CRB_MAX_HEIGHT 128 // a red-black tree of fewer than 2^63 nodes is never taller, a longer walk went through a half-done rotation
+#define CRB_MAX_ATTEMPTS 8 // optimistic tries of a read before it takes the writer's mutex
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause() // tell the core it is spinning, so it doesn't flood the memory system with loads
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+typedef struct cnode
+{
+    int key;                       // the integer value stored, never changed once the node is linked into the tree
+    _Atomic(struct cnode *) left;  // read by readers without a lock
+    _Atomic(struct cnode *) right; // read by readers without a lock
+    struct cnode *parent;          // only used by writers
+    int color;                     // RED or BLACK, only used by writers
+} CNode;
+typedef CNode *CNodePtr;
+
+typedef struct reader_slot
+{
+    _Atomic uint64_t state; // READER_IDLE, or (epoch << 1 | 1) while reading
+    atomic_bool taken;      // handed out by register_reader and not given back yet
+    char padding[55];       // one slot per cache line, so readers don't slow each other down
+} ReaderSlot;
+
+typedef struct ptr_vec
+{
+    void **items; // memory waiting to be freed
+    long size;
+    long cap;
+} PtrVec;
+
+typedef struct concurrent_tree
+{
+    _Atomic(CNodePtr) root; // root of the tree, NILL when it is empty
+    CNodePtr nill;          // NILL node of this tree, black, its links are never changed
+    pthread_mutex_t writer; // one writer at a time
+    _Atomic uint64_t seq;   // seqlock, odd while a writer is changing the tree
+    _Atomic uint64_t epoch; // global epoch, only advanced by writers
+    ReaderSlot slots[MAX_READERS];
+    atomic_int numreaders; // one more than the highest slot ever handed out, try_advance only looks at those
+    PtrVec limbo[3];       // limbo[e % 3] = nodes retired in epoch e, only touched by writers
+    atomic_long retries;   // optimistic reads that had to start over, for the benchmark
+} ConcurrentTree;
+typedef ConcurrentTree *ConcurrentTreePtr;
+
+ConcurrentTreePtr crb_create(void);                                                      // create an empty tree
+void crb_destroy(ConcurrentTreePtr *treePtr);                                            // destroy the tree, no reader or writer may be active
+int register_reader(ConcurrentTreePtr t);                                                // reserve a reader slot for the calling thread, -1 if all are taken
+void unregister_reader(ConcurrentTreePtr t, int slot);                                   // give the slot back, for the next thread that registers
+bool crb_search(ConcurrentTreePtr t, int slot, int key);                                 // whether key is in the tree, never waits for a writer unless it keeps losing the race; without a slot (-1) it reads under the writer's mutex
+long crb_range_fill(ConcurrentTreePtr t, int slot, int lo, int hi, int *keys, long max); // copy the first (at most max) keys in [lo, hi] to keys, as they all were at one moment; without a slot (-1) it reads under the writer's mutex
+void crb_insert(ConcurrentTreePtr t, int key);                                           // insert a node with key value
+bool crb_delete(ConcurrentTreePtr t, int key);                                           // delete a node with key value, false if there was none
+int concurrent_benchmark(int count, int numreaders, long updates);                       // reader throughput while a writer streams updates, lock-free vs one big lock
+
+int main(int argc, char **argv)
+{
+    // USAGE: ./concurrent bench <number of keys> <numreaders> <updates>
+    // example: gcc -O2 -pthread concurrent.c -o concurrent; ./concurrent bench 1000000 4 200000
+    if (argc == 5 && strcmp(argv[1], "bench") == 0)
+        return concurrent_benchmark(atoi(argv[2]), atoi(argv[3]), atol(argv[4]));
+
+    ConcurrentTreePtr t = crb_create(); // create the tree
+    int slot = register_reader(t);
+
+    // inserting nodes
+    for (int key = 10; key <= 50; key += 10)
+        crb_insert(t, key);
+
+    // deleting nodes
+    crb_delete(t, 20);
+    crb_delete(t, 10);
+
+    int keys[8];
+    long count = crb_range_fill(t, slot, 0, 100, keys, 8);
+    printf("%ld keys in [0, 100]:", count);
+    for (long i = 0; i < count; i++)
+        printf(" %d", keys[i]);
+    printf("\n30 is %sin the tree, 20 is %sin the tree\n", crb_search(t, slot, 30) ? "" : "not ", crb_search(t, slot, 20) ? "" : "not ");
+
+    unregister_reader(t, slot);
+    crb_destroy(&t); // destroy the tree
+    return 0;
+}
+
+static void ptr_vec_push(PtrVec *vec, void *item)
+{
+    if (vec->size == vec->cap)
+    {
+        vec->cap = vec->cap > 0 ? vec->cap * 2 : 64;
+        vec->items = realloc(vec->items, sizeof(void *) * vec->cap);
+    }
+    vec->items[vec->size++] = item;
+}
+
+static void ptr_vec_free_all(PtrVec *vec)
+{
+    for (long i = 0; i < vec->size; i++)
+        free(vec->items[i]);
+    vec->size = 0;
+}
+
+// writers hold the mutex, so they can read links relaxed; they store them with release so a reader that follows a new link sees the node's key
+static inline CNodePtr left_of(CNodePtr x)
+{
+    return atomic_load_explicit(&x->left, memory_order_relaxed);
+}
+
+static inline CNodePtr right_of(CNodePtr x)
+{
+    return atomic_load_explicit(&x->right, memory_order_relaxed);
+}
+
+static inline void set_left(CNodePtr x, CNodePtr y)
+{
+    atomic_store_explicit(&x->left, y, memory_order_release);
+}
+
+static inline void set_right(CNodePtr x, CNodePtr y)
+{
+    atomic_store_explicit(&x->right, y, memory_order_release);
+}
+
+static inline void set_root(ConcurrentTreePtr t, CNodePtr y)
+{
+    atomic_store_explicit(&t->root, y, memory_order_release);
+}
+
+static inline CNodePtr root_of(ConcurrentTreePtr t)
+{
+    return atomic_load_explicit(&t->root, memory_order_relaxed);
+}
+
+ConcurrentTreePtr crb_create(void)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    ConcurrentTreePtr t = calloc(1, sizeof(ConcurrentTree));
+    if (t == NULL)
+        return NULL; // just in case calloc failed
+    t->nill = malloc(sizeof(CNode));
+    t->nill->key = 0;
+    t->nill->color = BLACK; // color of NILL node is black
+    t->nill->parent = t->nill;
+    atomic_init(&t->nill->left, t->nill);
+    atomic_init(&t->nill->right, t->nill);
+    atomic_init(&t->root, t->nill); // at first, the root is NILL
+    atomic_init(&t->seq, 0);
+    atomic_init(&t->epoch, 1);
+    atomic_init(&t->numreaders, 0);
+    atomic_init(&t->retries, 0);
+    for (int s = 0; s < MAX_READERS; s++)
+    {
+        atomic_init(&t->slots[s].state, READER_IDLE);
+        atomic_init(&t->slots[s].taken, false);
+    }
+    pthread_mutex_init(&t->writer, NULL);
+    return t;
+}
+
+static void destroy_subtree(CNodePtr x, CNodePtr nill)
+{
+    if (x == nill)
+        return;
+    destroy_subtree(left_of(x), nill);
+    destroy_subtree(right_of(x), nill);
+    free(x);
+}
+
+void crb_destroy(ConcurrentTreePtr *treePtr)
+{
+    /*
+        Time Complexity: O(n + retired)
+        Space Complexity: O(log(n)) for the recursion
+    */
+    ConcurrentTreePtr t = *treePtr;
+    destroy_subtree(root_of(t), t->nill);
+    for (int e = 0; e < 3; e++)
+    {
+        ptr_vec_free_all(&t->limbo[e]);
+        free(t->limbo[e].items);
+    }
+    free(t->nill);
+    pthread_mutex_destroy(&t->writer);
+    free(t);
+    *treePtr = NULL;
+}
+
+int register_reader(ConcurrentTreePtr t)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    for (int slot = 0; slot < MAX_READERS; slot++)
+    {
+        bool expected = false;
+        if (atomic_load_explicit(&t->slots[slot].taken, memory_order_relaxed) || !atomic_compare_exchange_strong(&t->slots[slot].taken, &expected, true))
+            continue; // another thread has it
+        int high = atomic_load(&t->numreaders);
+        while (high < slot + 1 && !atomic_compare_exchange_weak(&t->numreaders, &high, slot + 1))
+            ; // raise the high-water mark, unless a thread that took a later slot already did
+        return slot;
+    }
+    return -1;
+}
+
+void unregister_reader(ConcurrentTreePtr t, int slot)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    if (slot < 0 || slot >= MAX_READERS)
+        return;
+    atomic_store_explicit(&t->slots[slot].state, READER_IDLE, memory_order_release);
+    atomic_store_explicit(&t->slots[slot].taken, false, memory_order_release);
+}
+
+static bool valid_slot(int slot)
+{
+    return slot >= 0 && slot < MAX_READERS;
+}
+
+static uint64_t read_seq(ConcurrentTreePtr t)
+{
+    // an even value of the seqlock: a writer in the middle of a change only relinks and recolors a few nodes, so spin until it is done
+    uint64_t seq;
+    while ((seq = atomic_load_explicit(&t->seq, memory_order_acquire)) & 1)
+        CPU_RELAX();
+    return seq;
+}
+
+static void read_begin(ConcurrentTreePtr t, int slot)
+{
+    // announce the epoch before touching any node: the writer never frees a node retired after the announcement
+    uint64_t epoch = atomic_load(&t->epoch);
+    atomic_store(&t->slots[slot].state, epoch << 1 | 1); // sequentially consistent, so the store is visible before the loads of the walk
+}
+
+static void read_end(ConcurrentTreePtr t, int slot)
+{
+    atomic_store_explicit(&t->slots[slot].state, READER_IDLE, memory_order_release);
+}
+
+static bool read_validate(ConcurrentTreePtr t, uint64_t seq)
+{
+    // no writer started or finished a change since the reader noted seq
+    atomic_thread_fence(memory_order_acquire); // the walk's loads happen before the second read of the counter
+    return atomic_load_explicit(&t->seq, memory_order_relaxed) == seq;
+}
+
+static int search_attempt(ConcurrentTreePtr t, int key)
+{
+    // one optimistic descent: 1 if found, 0 if not, -1 if the walk ran too long and must be retried
+    CNodePtr x = atomic_load_explicit(&t->root, memory_order_acquire);
+    for (int steps = 0; x != t->nill; steps++)
+    {
+        if (steps > CRB_MAX_HEIGHT)
+            return -1;
+        if (x->key == key)
+            return 1;
+        x = key < x->key ? atomic_load_explicit(&x->left, memory_order_acquire) : atomic_load_explicit(&x->right, memory_order_acquire);
+    }
+    return 0;
+}
+
+bool crb_search(ConcurrentTreePtr t, int slot, int key)
+{
+    /*
+        Time Complexity: O(log(n)) per attempt, an attempt only fails if a write changed the tree during it
+        Space Complexity: O(1)
+    */
+    if (!valid_slot(slot))
+    {
+        // no slot to announce the epoch in, so the nodes might be freed under an optimistic walk
+        pthread_mutex_lock(&t->writer);
+        int found = search_attempt(t, key);
+        pthread_mutex_unlock(&t->writer);
+        return found;
+    }
+    read_begin(t, slot);
+    for (int attempt = 0; attempt < CRB_MAX_ATTEMPTS; attempt++)
+    {
+        uint64_t seq = read_seq(t); // only a failed validation counts as an attempt
+        int found = search_attempt(t, key);
+        if (found >= 0 && read_validate(t, seq))
+        {
+            read_end(t, slot);
+            return found;
+        }
+        atomic_fetch_add_explicit(&t->retries, 1, memory_order_relaxed);
+    }
+    read_end(t, slot);
+
+    // writes keep landing in the middle of the walk, search with the writers held off
+    pthread_mutex_lock(&t->writer);
+    int found = search_attempt(t, key);
+    pthread_mutex_unlock(&t->writer);
+    return found;
+}
+
+static long range_attempt(ConcurrentTreePtr t, int lo, int hi, int *keys, long max)
+{
+    // one optimistic in-order walk of the nodes in [lo, hi] with an explicit stack, -1 if it ran too long
+    CNodePtr stack[CRB_MAX_HEIGHT];
+    int depth = 0;
+    long count = 0, steps = 0;
+    CNodePtr x = atomic_load_explicit(&t->root, memory_order_acquire);
+    while ((x != t->nill || depth > 0) && count < max)
+    {
+        if (++steps > 4 * CRB_MAX_HEIGHT + 2 * count)
+            return -1; // a valid walk visits the two boundary paths and each key in the range about twice
+        if (x != t->nill)
+        {
+            if (x->key < lo)
+            {
+                x = atomic_load_explicit(&x->right, memory_order_acquire); // x and its left subtree are below the range
+                continue;
+            }
+            if (depth == CRB_MAX_HEIGHT)
+                return -1;
+            stack[depth++] = x;
+            x = atomic_load_explicit(&x->left, memory_order_acquire);
+        }
+        else
+        {
+            x = stack[--depth];
+            if (x->key > hi)
+                break; // every key from here on is above the range
+            keys[count++] = x->key;
+            x = atomic_load_explicit(&x->right, memory_order_acquire);
+        }
+    }
+    return count;
+}
+
+long crb_range_fill(ConcurrentTreePtr t, int slot, int lo, int hi, int *keys, long max)
+{
+    /*
+        Time Complexity: O(log(n) + k) per attempt for the k keys copied
+        Space Complexity: O(log(n)) for the stack of the walk
+    */
+    if (!valid_slot(slot))
+    {
+        pthread_mutex_lock(&t->writer);
+        long count = range_attempt(t, lo, hi, keys, max);
+        pthread_mutex_unlock(&t->writer);
+        return count;
+    }
+    read_begin(t, slot);
+    for (int attempt = 0; attempt < CRB_MAX_ATTEMPTS; attempt++)
+    {
+        uint64_t seq = read_seq(t);
+        long count = range_attempt(t, lo, hi, keys, max);
+        if (count >= 0 && read_validate(t, seq))
+        {
+            read_end(t, slot); // keys holds copies, nothing of the tree is used after this
+            return count;
+        }
+        atomic_fetch_add_explicit(&t->retries, 1, memory_order_relaxed);
+    }
+    read_end(t, slot);
+
+    pthread_mutex_lock(&t->writer);
+    long count = range_attempt(t, lo, hi, keys, max);
+    pthread_mutex_unlock(&t->writer);
+    return count;
+}
+
+static void write_open(ConcurrentTreePtr t)
+{
+    // the seqlock becomes odd: readers that overlap the change will retry
+    uint64_t seq = atomic_load_explicit(&t->seq, memory_order_relaxed);
+    atomic_store_explicit(&t->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // the odd value is visible before any change to a link
+}
+
+static void write_close(ConcurrentTreePtr t)
+{
+    uint64_t seq = atomic_load_explicit(&t->seq, memory_order_relaxed);
+    atomic_store_explicit(&t->seq, seq + 1, memory_order_release); // every change is visible before the even value
+}
+
+static void rotate_left(ConcurrentTreePtr t, CNodePtr bst)
+{
+    // left rotation on bst node
+    CNodePtr y = right_of(bst); // y is bst's right child
+    set_right(bst, left_of(y)); // bst's right child becomes y's left child
+    if (left_of(y) != t->nill)
+        left_of(y)->parent = bst; // set the parent of y's left child to bst
+
+    y->parent = bst->parent; // y's parent becomes bst's parent
+    if (bst->parent == t->nill)
+        set_root(t, y); // if bst is the root
+    else if (bst == left_of(bst->parent))
+        set_left(bst->parent, y); // if bst is bst's parent's left child
+    else
+        set_right(bst->parent, y); // if bst is bst's parent's right child
+
+    set_left(y, bst); // y's left child becomes bst
+    bst->parent = y;  // bst's parent becomes y
+}
+
+static void rotate_right(ConcurrentTreePtr t, CNodePtr bst)
+{
+    CNodePtr y = left_of(bst);  // y is bst's left child
+    set_left(bst, right_of(y)); // bst's left child becomes y's right child
+    if (right_of(y) != t->nill)
+        right_of(y)->parent = bst; // set the parent of y's right child to bst
+
+    y->parent = bst->parent; // y's parent becomes bst's parent
+    if (bst->parent == t->nill)
+        set_root(t, y); // if bst is the root
+    else if (bst == left_of(bst->parent))
+        set_left(bst->parent, y); // if bst is bst's parent's left child
+    else
+        set_right(bst->parent, y); // if bst is bst's parent's right child
+
+    set_right(y, bst); // y's right child becomes bst
+    bst->parent = y;   // bst's parent becomes y
+}
+
+static void insert_fix(ConcurrentTreePtr t, CNodePtr bst)
+{
+    // same cases as rb_insert_fix in main.c
+    while (bst->parent->color == RED)
+    {
+        CNodePtr p = bst->parent, g = p->parent;
+        if (p == left_of(g))
+        {
+            CNodePtr uncle = right_of(g);
+            if (uncle->color == RED)
+            {
+                p->color = BLACK; // recolor and move up the tree
+                uncle->color = BLACK;
+                g->color = RED;
+                bst = g;
+                continue;
+            }
+            if (bst == right_of(p))
+            {
+                bst = p; // z is its parent's right child: rotate it to the outside first
+                rotate_left(t, bst);
+            }
+            bst->parent->color = BLACK;
+            bst->parent->parent->color = RED;
+            rotate_right(t, bst->parent->parent);
+        }
+        else
+        {
+            CNodePtr uncle = left_of(g);
+            if (uncle->color == RED)
+            {
+                p->color = BLACK;
+                uncle->color = BLACK;
+                g->color = RED;
+                bst = g;
+                continue;
+            }
+            if (bst == left_of(p))
+            {
+                bst = p;
+                rotate_right(t, bst);
+            }
+            bst->parent->color = BLACK;
+            bst->parent->parent->color = RED;
+            rotate_left(t, bst->parent->parent);
+        }
+    }
+    root_of(t)->color = BLACK;
+}
+
+void crb_insert(ConcurrentTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log(n)), readers only have to retry if they overlap the relinking and rebalancing, not the descent
+        Space Complexity: O(1)
+    */
+    CNodePtr nu = malloc(sizeof(CNode)); // alloc memory for a new node, before any lock
+    nu->key = key;
+    nu->color = RED; // assume new node is red
+    atomic_init(&nu->left, NULL);
+    atomic_init(&nu->right, NULL);
+
+    pthread_mutex_lock(&t->writer);
+    atomic_store_explicit(&nu->left, t->nill, memory_order_relaxed);
+    atomic_store_explicit(&nu->right, t->nill, memory_order_relaxed);
+    CNodePtr tmp = root_of(t), tmp_parent = t->nill;
+    while (tmp != t->nill)
+    {
+        // find where to place the new node, the tree does not change yet
+        tmp_parent = tmp;
+        tmp = key <= tmp->key ? left_of(tmp) : right_of(tmp);
+    }
+    nu->parent = tmp_parent;
+
+    write_open(t);
+    if (tmp_parent == t->nill)
+        set_root(t, nu); // if the tree is empty, the new node becomes the root
+    else if (key <= tmp_parent->key)
+        set_left(tmp_parent, nu);
+    else
+        set_right(tmp_parent, nu);
+    insert_fix(t, nu); // fix the red black tree after insertion
+    write_close(t);
+    pthread_mutex_unlock(&t->writer);
+}
+
+static void replace(ConcurrentTreePtr t, CNodePtr x, CNodePtr y)
+{
+    // put y where x is
+    if (x->parent == t->nill)
+        set_root(t, y);
+    else if (x == left_of(x->parent))
+        set_left(x->parent, y);
+    else
+        set_right(x->parent, y);
+    y->parent = x->parent; // may write NILL's parent, which only the delete fix up reads
+}
+
+static void delete_fix(ConcurrentTreePtr t, CNodePtr x)
+{
+    // same cases as rb_delete_fix in main.c
+    while (x != root_of(t) && x->color == BLACK)
+    {
+        if (x == left_of(x->parent))
+        {
+            CNodePtr w = right_of(x->parent);
+            if (w->color == RED)
+            {
+                w->color = BLACK;
+                x->parent->color = RED;
+                rotate_left(t, x->parent);
+                w = right_of(x->parent);
+            }
+            if (left_of(w)->color == BLACK && right_of(w)->color == BLACK)
+            {
+                w->color = RED;
+                x = x->parent;
+            }
+            else
+            {
+                if (right_of(w)->color == BLACK)
+                {
+                    left_of(w)->color = BLACK;
+                    w->color = RED;
+                    rotate_right(t, w);
+                    w = right_of(x->parent);
+                }
+                w->color = x->parent->color;
+                x->parent->color = BLACK;
+                right_of(w)->color = BLACK;
+                rotate_left(t, x->parent);
+                x = root_of(t);
+            }
+        }
+        else
+        {
+            CNodePtr w = left_of(x->parent);
+            if (w->color == RED)
+            {
+                w->color = BLACK;
+                x->parent->color = RED;
+                rotate_right(t, x->parent);
+                w = left_of(x->parent);
+            }
+            if (right_of(w)->color == BLACK && left_of(w)->color == BLACK)
+            {
+                w->color = RED;
+                x = x->parent;
+            }
+            else
+            {
+                if (left_of(w)->color == BLACK)
+                {
+                    right_of(w)->color = BLACK;
+                    w->color = RED;
+                    rotate_left(t, w);
+                    w = left_of(x->parent);
+                }
+                w->color = x->parent->color;
+                x->parent->color = BLACK;
+                left_of(w)->color = BLACK;
+                rotate_right(t, x->parent);
+                x = root_of(t);
+            }
+        }
+    }
+    x->color = BLACK;
+}
+
+static void try_advance(ConcurrentTreePtr t)
+{
+    // move to the next epoch if every active reader has seen the current one, then free what was retired two epochs ago
+    uint64_t epoch = atomic_load(&t->epoch);
+    int numreaders = atomic_load(&t->numreaders);
+    for (int s = 0; s < numreaders && s < MAX_READERS; s++)
+    {
+        uint64_t state = atomic_load(&t->slots[s].state);
+        if (state != READER_IDLE && (state >> 1) != epoch)
+            return; // a reader from an older epoch may still be looking at nodes retired then
+    }
+    atomic_store(&t->epoch, epoch + 1);
+    ptr_vec_free_all(&t->limbo[(epoch + 2) % 3]); // retired in epoch - 1, no active reader is older than epoch now
+}
+
+bool crb_delete(ConcurrentTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log(n)), plus whatever epoch based reclamation frees
+        Space Complexity: O(1)
+    */
+    pthread_mutex_lock(&t->writer);
+    CNodePtr bst = root_of(t);
+    while (bst != t->nill && bst->key != key)
+        bst = key < bst->key ? left_of(bst) : right_of(bst); // search for the node to be deleted
+    if (bst == t->nill)
+    {
+        pthread_mutex_unlock(&t->writer);
+        return false; // the key is not in the tree
+    }
+
+    write_open(t);
+    CNodePtr y = bst, x;
+    int yOriginalColor = y->color;
+    if (left_of(bst) == t->nill)
+    {
+        x = right_of(bst);
+        replace(t, bst, x);
+    }
+    else if (right_of(bst) == t->nill)
+    {
+        x = left_of(bst);
+        replace(t, bst, x);
+    }
+    else
+    {
+        y = right_of(bst); // the successor of bst, leftmost node of its right subtree
+        while (left_of(y) != t->nill)
+            y = left_of(y);
+        yOriginalColor = y->color;
+        x = right_of(y);
+        if (y->parent == bst)
+            x->parent = y;
+        else
+        {
+            replace(t, y, right_of(y));
+            set_right(y, right_of(bst));
+            right_of(y)->parent = y;
+        }
+        replace(t, bst, y);
+        set_left(y, left_of(bst));
+        left_of(y)->parent = y;
+        y->color = bst->color;
+    }
+    if (yOriginalColor == BLACK)
+        delete_fix(t, x);
+    write_close(t);
+
+    // a reader that started before write_close may still be on bst
+    ptr_vec_push(&t->limbo[atomic_load_explicit(&t->epoch, memory_order_relaxed) % 3], bst);
+    try_advance(t);
+    pthread_mutex_unlock(&t->writer);
+    return true;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct reader_task
+{
+    ConcurrentTreePtr t;
+    bool locked;       // take the writer's mutex around every read, like a tree with one big lock
+    atomic_bool *done; // set once the writer has finished
+    int count;         // even keys 0 .. 2 * (count - 1) are always in the tree
+    uint64_t seed;     // keys to look up
+    long reads;        // searches and scans done by this reader
+    long violations;   // keys that are always in the tree but were not found, or scans out of order, must stay 0
+} ReaderTask;
+
+static void *reader_worker(void *arg)
+{
+    ReaderTask *task = arg;
+    ConcurrentTreePtr t = task->t;
+    int slot = register_reader(t);
+    uint64_t state = task->seed;
+    int keys[16];
+    task->reads = 0;
+    task->violations = 0;
+    while (!atomic_load_explicit(task->done, memory_order_relaxed))
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        int key = (int)((state >> 33) % task->count) * 2;
+        if (task->locked)
+            pthread_mutex_lock(&t->writer);
+        if (task->reads % 16 != 15)
+            task->violations += task->locked ? !search_attempt(t, key) : !crb_search(t, slot, key);
+        else
+        {
+            // every 16th read is a scan, which must see the always-present keys in order
+            long count = task->locked ? range_attempt(t, key, key + 14, keys, 16) : crb_range_fill(t, slot, key, key + 14, keys, 16);
+            int expected = key;
+            for (long i = 0; i < count; i++)
+            {
+                if (keys[i] % 2 == 0)
+                {
+                    task->violations += keys[i] != expected;
+                    expected += 2;
+                }
+            }
+            task->violations += expected <= key + 14 && expected <= 2 * (task->count - 1);
+        }
+        if (task->locked)
+            pthread_mutex_unlock(&t->writer);
+        task->reads++;
+    }
+    unregister_reader(t, slot);
+    return NULL;
+}
+
+int concurrent_benchmark(int count, int numreaders, long updates)
+{
+    /*
+        Time Complexity: O(count * log(count)) to build the tree, O(updates * log(count)) for the writer
+        Space Complexity: O(count)
+    */
+    if (numreaders < 1 || numreaders > MAX_READERS)
+        numreaders = 1;
+    if (count < 8)
+        count = 8;
+    printf("keys %d | readers %d | updates %ld\n", count, numreaders, updates);
+    bool ok = true;
+
+    for (int locked = 1; locked >= 0; locked--)
+    {
+        // the even keys stay in the tree, the writer inserts and deletes odd keys
+        ConcurrentTreePtr t = crb_create();
+        for (int i = 0; i < count; i++)
+            crb_insert(t, 2 * i);
+
+        atomic_bool done;
+        atomic_init(&done, false);
+        pthread_t *threads = malloc(sizeof(pthread_t) * numreaders);
+        ReaderTask *tasks = malloc(sizeof(ReaderTask) * numreaders);
+        for (int r = 0; r < numreaders; r++)
+        {
+            tasks[r].t = t;
+            tasks[r].locked = locked;
+            tasks[r].done = &done;
+            tasks[r].count = count;
+            tasks[r].seed = r + 1;
+            pthread_create(&threads[r], NULL, reader_worker, &tasks[r]);
+        }
+
+        // every odd key inserted is deleted again 64 updates later
+        int pending[64];
+        srand(42);
+        double start = now_seconds();
+        for (long i = 0; i < updates; i++)
+        {
+            int k = (int)(i % 64);
+            if (i >= 64)
+                crb_delete(t, pending[k]);
+            pending[k] = (rand() % count) * 2 + 1;
+            crb_insert(t, pending[k]);
+        }
+        double elapsed = now_seconds() - start;
+        atomic_store(&done, true);
+
+        long reads = 0, violations = 0;
+        for (int r = 0; r < numreaders; r++)
+        {
+            pthread_join(threads[r], NULL);
+            reads += tasks[r].reads;
+            violations += tasks[r].violations;
+        }
+        printf("%-9s | %.3f s | %.0f updates/s | %.0f reads/s | retried reads: %ld | wrong reads: %ld\n",
+               locked ? "big lock" : "lock-free", elapsed, updates / elapsed, reads / elapsed, (long)atomic_load(&t->retries), violations);
+        ok = ok && violations == 0;
+
+        free(threads);
+        free(tasks);
+        crb_destroy(&t);
+    }
+    return ok ? 0 : 1;
+}
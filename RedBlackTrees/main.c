@@ -1,385 +1,1096 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
 #define BLACK 0
 #define RED 1
+#define NILL 0                 // index of the NILL node, which is always the first node of the pool
+#define COLOR_BIT 0x80000000u  // the color is stored in the top bit of parent_color
+#define INDEX_MASK 0x7fffffffu // the other 31 bits hold the parent's index, so a tree holds at most 2^31 - 1 nodes
+#define POOL_MIN_CAPACITY 16   // nodes allocated by the first growth of an empty pool
+#ifndef RB_ORDER_STATISTICS
+#define RB_ORDER_STATISTICS 0 // compile with -DRB_ORDER_STATISTICS=1 to keep subtree sizes for rb_rank, rb_select and rb_count_range, at 20 bytes per node
+#endif
 
+typedef uint32_t NodeIdx; // index of a node in the pool
 typedef struct node
 {
-    int key; // the integer value stored
-    struct node *parent;
-    struct node *left;
-    struct node *right;
-    int color; // RED or BLACK (RED = 1, BLACK = 0)
-} Node;
-typedef Node *NodePtr;
-NodePtr ROOT; // root of the tree, accessed by almost all the functions in the program, so we set it as a constant
-NodePtr NILL; // NILL node, accessed by almost all the functions in the program, we set it as a constant
-
-void rb_insert(int key);                  // insert a node with key value
-void rb_print(NodePtr bst);               // print the tree sideways
-void rb_insert_fix(NodePtr z);            // fix the tree after insertion
-void rb_rotate_right(NodePtr x);          // rotate the tree to the right on x
-void rb_rotate_left(NodePtr x);           // rotate the tree to the left on x
-void rb_setup();                          // setup the tree
-void rb_delete(int key);                  // delete a node with key value
-void rb_delete_fix(NodePtr x);            // fix the tree after deletion
-NodePtr rb_search(NodePtr root, int key); // search for a node with key value
-void destroy_bst(NodePtr *bstPtr);        // destroy the tree
-int main(void)
-{
-    rb_setup(); // setup the red-black tree
+    int key;               // the integer value stored
+    NodeIdx left;          // index of the left child
+    NodeIdx right;         // index of the right child
+    uint32_t parent_color; // index of the parent, with the color in the top bit (RED = 1, BLACK = 0)
+#if RB_ORDER_STATISTICS
+    uint32_t size; // number of nodes in the subtree rooted here, 0 for NILL
+#endif
+} Node; // 16 bytes (four nodes per cache line), 20 with subtree sizes
+
+typedef struct rb_tree
+{
+    NodeIdx root;      // root of the tree, NILL when it is empty
+    Node *nodes;       // every node of the tree, nodes[NILL] is the NILL node
+    uint32_t capacity; // number of nodes allocated
+    uint32_t used;     // nodes handed out at least once, including NILL; nodes[used] onwards were never used
+    NodeIdx free;      // most recently released node, released nodes are chained through their left index (NILL ends the list)
+} RbTree;              // one tree: trees share nothing, so different threads can work on different trees without locks
+typedef RbTree *RbTreePtr;
+typedef void (*RbVisit)(void *context, int key); // called by rb_range for every key in the range, in increasing order
+
+RbTreePtr rb_create(uint32_t capacity);       // create an empty tree, with room for capacity nodes before its pool grows
+void rb_insert(RbTreePtr t, int key);         // insert a node with key value
+void rb_print(RbTreePtr t);                   // print the tree sideways
+void rb_insert_fix(RbTreePtr t, NodeIdx z);   // fix the tree after insertion
+void rb_rotate_right(RbTreePtr t, NodeIdx x); // rotate the tree to the right on x
+void rb_rotate_left(RbTreePtr t, NodeIdx x);  // rotate the tree to the left on x
+void rb_delete(RbTreePtr t, int key);         // delete a node with key value
+void rb_delete_fix(RbTreePtr t, NodeIdx x);   // fix the tree after deletion
+NodeIdx rb_search(RbTreePtr t, int key);      // search for a node with key value, NILL if there is none
+void destroy_bst(RbTreePtr *treePtr);         // destroy the tree
+
+int rb_key(RbTreePtr t, NodeIdx x);                                       // key stored in node x
+NodeIdx rb_first(RbTreePtr t);                                            // node with the smallest key, NILL if the tree is empty
+NodeIdx rb_last(RbTreePtr t);                                             // node with the largest key, NILL if the tree is empty
+NodeIdx rb_next(RbTreePtr t, NodeIdx x);                                  // node after x in key order, NILL after the last node
+NodeIdx rb_prev(RbTreePtr t, NodeIdx x);                                  // node before x in key order, NILL before the first node
+NodeIdx rb_lower_bound(RbTreePtr t, int key);                             // first node with a key >= key, NILL if there is none
+NodeIdx rb_upper_bound(RbTreePtr t, int key);                             // first node with a key > key, NILL if there is none
+long rb_range(RbTreePtr t, int lo, int hi, RbVisit visit, void *context); // visit every key in [lo, hi], returns how many there were
+long rb_range_fill(RbTreePtr t, int lo, int hi, int *keys, long max);     // copy the first (at most max) keys in [lo, hi] to keys, returns how many were copied
+#if RB_ORDER_STATISTICS
+long rb_rank(RbTreePtr t, int key);               // number of keys smaller than key
+NodeIdx rb_select(RbTreePtr t, long k);           // node with the k-th smallest key (k = 0 is the smallest), NILL if there are not enough keys
+long rb_count_range(RbTreePtr t, int lo, int hi); // number of keys in [lo, hi]
+#endif
+
+RbTreePtr rb_build(const int *keys, long count); // build a tree from count keys in increasing order in O(count), NULL if they are not sorted
+RbTreePtr rb_merge(RbTreePtr a, RbTreePtr b);    // build a tree holding the keys of both a and b in O(|a| + |b|), a and b are not changed
+
+int rb_benchmark(int count);                    // time count inserts, searches and deletes of random keys
+int shard_benchmark(int count, int numthreads); // time count inserts and searches spread over one tree per thread
+int bulk_benchmark(int count);                  // time rb_build and rb_merge against inserting the same keys one at a time
+#ifndef RB_NO_MAIN // bench.c includes this file and brings its own main
+int main(int argc, char **argv)
+{
+    // USAGE: ./main bench <number of keys>
+    // example: gcc -O2 -pthread -DRB_ORDER_STATISTICS=1 main.c -o main; ./main bench 1000000
+    if (argc == 3 && strcmp(argv[1], "bench") == 0)
+        return rb_benchmark(atoi(argv[2]));
+
+    // USAGE: ./main shards <number of keys> <numthreads>
+    // example: gcc -O2 -pthread main.c -o main; ./main shards 4000000 4
+    if (argc == 4 && strcmp(argv[1], "shards") == 0)
+        return shard_benchmark(atoi(argv[2]), atoi(argv[3]));
+
+    // USAGE: ./main bulk <number of keys>
+    // example: gcc -O2 -pthread main.c -o main; ./main bulk 1000000
+    if (argc == 3 && strcmp(argv[1], "bulk") == 0)
+        return bulk_benchmark(atoi(argv[2]));
+
+    RbTreePtr t = rb_create(0);     // create the red-black tree
+    RbTreePtr evens = rb_create(0); // a second tree, independent of the first
 
     // inserting nodes
-    rb_insert(10);
-    rb_insert(20);
-    rb_insert(30);
-    rb_insert(40);
-    rb_insert(50);
+    rb_insert(t, 10);
+    rb_insert(t, 20);
+    rb_insert(t, 30);
+    rb_insert(t, 40);
+    rb_insert(t, 50);
+    for (int i = 0; i < 10; i += 2)
+        rb_insert(evens, i);
 
     // deleting nodes
-    rb_delete(20);
-    rb_delete(10);
+    rb_delete(t, 20);
+    rb_delete(t, 10);
+
+    rb_print(t); // print the tree sideways
+    printf("\n");
+    rb_print(evens);
+
+    // walking the tree in order
+    printf("\nkeys of the first tree in [25, 45]:");
+    for (NodeIdx x = rb_lower_bound(t, 25); x != NILL && rb_key(t, x) <= 45; x = rb_next(t, x))
+        printf(" %d", rb_key(t, x));
+    printf("\nkeys of the second tree, largest first:");
+    for (NodeIdx x = rb_last(evens); x != NILL; x = rb_prev(evens, x))
+        printf(" %d", rb_key(evens, x));
+    int found[5];
+    long numfound = rb_range_fill(evens, 3, 100, found, 5);
+    printf("\n%ld keys of the second tree in [3, 100]:", numfound);
+    for (long i = 0; i < numfound; i++)
+        printf(" %d", found[i]);
+    printf("\n");
+#if RB_ORDER_STATISTICS
+    NodeIdx median = rb_select(evens, 2);
+    printf("rank of 5: %ld, median: %d, keys in [1, 6]: %ld\n", rb_rank(evens, 5), rb_key(evens, median), rb_count_range(evens, 1, 6));
+#endif
+
+    // building trees from sorted keys
+    int odds[] = {1, 3, 5, 7, 9, 11};
+    RbTreePtr built = rb_build(odds, 6);
+    RbTreePtr merged = rb_merge(built, evens);
+    printf("merged:");
+    for (NodeIdx x = rb_first(merged); x != NILL; x = rb_next(merged, x))
+        printf(" %d", rb_key(merged, x));
+    printf("\n");
 
-    rb_print(ROOT);     // print the tree sideways
-    destroy_bst(&ROOT); // destroy the tree;
+    destroy_bst(&t); // destroy the trees
+    destroy_bst(&evens);
+    destroy_bst(&built);
+    destroy_bst(&merged);
 
     return 0;
 }
+#endif
 
-void rb_setup()
+static inline Node *node(RbTreePtr t, NodeIdx x)
 {
-    // this function should be run before inserting any node into the tree
-    NILL = malloc(sizeof(struct node)); // create NILL node
-    NILL->color = BLACK;                // color of NILL node is black
-    ROOT = NILL;                        // at first, the root is NILL
+    // only valid until the next pool_alloc, which may move the pool
+    return &t->nodes[x];
 }
 
-void rb_insert(int key)
+static inline NodeIdx parent(RbTreePtr t, NodeIdx x)
 {
-    NodePtr nu = (NodePtr)malloc(sizeof(Node)); // alloc memory for a new node
-    nu->key = key;                              // set the key value
-    nu->left = nu->right = NILL;                // set the left and right child of the new node to NILL
-    nu->color = RED;                            // assume new node is red
+    return t->nodes[x].parent_color & INDEX_MASK;
+}
+
+static inline int color(RbTreePtr t, NodeIdx x)
+{
+    return t->nodes[x].parent_color >> 31;
+}
+
+static inline void set_parent(RbTreePtr t, NodeIdx x, NodeIdx p)
+{
+    t->nodes[x].parent_color = (t->nodes[x].parent_color & COLOR_BIT) | p; // keep the color
+}
 
-    NodePtr tmp = ROOT;        // start from the root
-    NodePtr tmp_parent = NILL; // temporary parent of the new node
+static inline void set_color(RbTreePtr t, NodeIdx x, int c)
+{
+    t->nodes[x].parent_color = (t->nodes[x].parent_color & INDEX_MASK) | ((uint32_t)c << 31); // keep the parent
+}
+
+NodeIdx pool_alloc(RbTreePtr t)
+{
+    /*
+        Time Complexity: O(1) amortized, the pool doubles when it is full
+        Space Complexity: O(1) amortized
+    */
+    if (t->free != NILL)
+    {
+        // reuse the most recently released node, it is likely still in the cache
+        NodeIdx x = t->free;
+        t->free = t->nodes[x].left;
+        return x;
+    }
+    if (t->used == t->capacity)
+    {
+        if (t->capacity > INDEX_MASK / 2)
+            return NILL; // the parent index has no room for more nodes
+        uint32_t capacity = t->capacity < POOL_MIN_CAPACITY ? POOL_MIN_CAPACITY : t->capacity * 2;
+        Node *nodes = realloc(t->nodes, sizeof(Node) * capacity); // nodes refer to each other by index, so moving them is fine
+        if (nodes == NULL)
+            return NILL;
+        t->nodes = nodes;
+        t->capacity = capacity;
+    }
+    return t->used++;
+}
+
+void pool_release(RbTreePtr t, NodeIdx x)
+{
+    // Time Complexity: O(1)
+    t->nodes[x].left = t->free;
+    t->free = x;
+}
+
+RbTreePtr rb_create(uint32_t capacity)
+{
+    // every tree has its own pool, and so its own NILL node
+    RbTreePtr t = malloc(sizeof(RbTree));
+    t->capacity = capacity + 1; // one more for the NILL node
+    t->nodes = malloc(sizeof(Node) * t->capacity);
+    t->used = 1;
+    t->free = NILL;
+    t->nodes[NILL].key = 0;
+    t->nodes[NILL].left = t->nodes[NILL].right = NILL;
+    t->nodes[NILL].parent_color = NILL; // color of NILL node is black
+    t->root = NILL;                     // at first, the root is NILL
+#if RB_ORDER_STATISTICS
+    t->nodes[NILL].size = 0; // NILL is never counted, so the size of a node is always left size + right size + 1
+#endif
+    return t;
+}
+
+void rb_insert(RbTreePtr t, int key)
+{
+    NodeIdx nu = pool_alloc(t); // take a node from the pool
+    if (nu == NILL)
+    {
+        printf("Could not allocate a node for %d\n", key);
+        return;
+    }
+    node(t, nu)->key = key;                        // set the key value
+    node(t, nu)->left = node(t, nu)->right = NILL; // set the left and right child of the new node to NILL
+    node(t, nu)->parent_color = COLOR_BIT | NILL;  // assume new node is red
+#if RB_ORDER_STATISTICS
+    node(t, nu)->size = 1;
+#endif
+
+    NodeIdx tmp = t->root;     // start from the root
+    NodeIdx tmp_parent = NILL; // temporary parent of the new node
 
     while (tmp != NILL)
     {
         // find where to place the new node
         tmp_parent = tmp;
-        if (key <= tmp->key)
-            tmp = tmp->left; // go left if the key is smaller than the current node
+#if RB_ORDER_STATISTICS
+        node(t, tmp)->size++; // the new node ends up below tmp
+#endif
+        if (key <= node(t, tmp)->key)
+            tmp = node(t, tmp)->left; // go left if the key is smaller than the current node
         else
-            tmp = tmp->right; // go right if the key is larger than the current node
+            tmp = node(t, tmp)->right; // go right if the key is larger than the current node
     }
 
     if (tmp_parent == NILL)
-        ROOT = nu; // if the tree is empty, the new node becomes the root
-    else if (nu->key <= tmp_parent->key)
-        tmp_parent->left = nu;
+        t->root = nu; // if the tree is empty, the new node becomes the root
+    else if (key <= node(t, tmp_parent)->key)
+        node(t, tmp_parent)->left = nu;
     else
-        tmp_parent->right = nu;
+        node(t, tmp_parent)->right = nu;
 
-    nu->parent = tmp_parent;
+    set_parent(t, nu, tmp_parent);
 
-    rb_insert_fix(nu); // fix the red black tree after insertion
+    rb_insert_fix(t, nu); // fix the red black tree after insertion
 }
 
-void rb_insert_fix(NodePtr bst)
+void rb_insert_fix(RbTreePtr t, NodeIdx bst)
 {
-    while (bst->parent->color == RED)
+    while (color(t, parent(t, bst)) == RED)
     {
+        NodeIdx p = parent(t, bst); // node's parent
+        NodeIdx g = parent(t, p);   // node's grand parent
+
         //  node's parent is left child of node's grand parent
-        if (bst->parent == bst->parent->parent->left)
+        if (p == node(t, g)->left)
         {
+            NodeIdx uncle = node(t, g)->right;
             // node's grand parent's right child is RED
-            if (bst->parent->parent->right != NILL && bst->parent->parent->right->color == RED)
+            if (uncle != NILL && color(t, uncle) == RED)
             {
-                bst->parent->color = BLACK;                // set parent's color to black
-                bst->parent->parent->right->color = BLACK; // set grandparent's right child's color to black
-                bst->parent->parent->color = RED;          // set grandparent's color to red
-                bst = bst->parent->parent;                 // move up the tree
+                set_color(t, p, BLACK);     // set parent's color to black
+                set_color(t, uncle, BLACK); // set grandparent's right child's color to black
+                set_color(t, g, RED);       // set grandparent's color to red
+                bst = g;                    // move up the tree
             }
 
             // node's grand parent's right child is not RED
             else
             {
                 /* z is z's parent's right child */
-                if (bst == bst->parent->right)
+                if (bst == node(t, p)->right)
                 {
-                    bst = bst->parent;   // move up the tree
-                    rb_rotate_left(bst); // left rotation on node
+                    bst = p;                // move up the tree
+                    rb_rotate_left(t, bst); // left rotation on node
                 }
 
-                bst->parent->color = BLACK;           // set parent's color to black
-                bst->parent->parent->color = RED;     // set grandparent's color to red
-                rb_rotate_right(bst->parent->parent); // right rotation on grandparent
+                set_color(t, parent(t, bst), BLACK);           // set parent's color to black
+                set_color(t, parent(t, parent(t, bst)), RED);  // set grandparent's color to red
+                rb_rotate_right(t, parent(t, parent(t, bst))); // right rotation on grandparent
             }
         }
 
         /* z's parent is z's grand parent's right child */
         else
         {
+            NodeIdx uncle = node(t, g)->left;
             //  z's left uncle or z's grand parent's left child is also RED
-            if (bst->parent->parent->left != NILL && bst->parent->parent->left->color == RED)
+            if (uncle != NILL && color(t, uncle) == RED)
             {
                 // the grandparent's left child is RED
-                bst->parent->color = BLACK;               // set parent's color to black
-                bst->parent->parent->left->color = BLACK; // set grandparent's left child's color to black
-                bst->parent->parent->color = RED;         // set grandparent's color to red
-                bst = bst->parent->parent;                // move up the tree
+                set_color(t, p, BLACK);     // set parent's color to black
+                set_color(t, uncle, BLACK); // set grandparent's left child's color to black
+                set_color(t, g, RED);       // set grandparent's color to red
+                bst = g;                    // move up the tree
             }
 
             else
             {
                 //  z's left uncle is BLACK
-                if (bst == bst->parent->left)
+                if (bst == node(t, p)->left)
                 {
                     // z is z's parents left child
-                    bst = bst->parent;    // move up the tree
-                    rb_rotate_right(bst); // right rotation on node
+                    bst = p;                 // move up the tree
+                    rb_rotate_right(t, bst); // right rotation on node
                 }
-                bst->parent->color = BLACK;          // set parent's color to black
-                bst->parent->parent->color = RED;    // set grandparent's color to red
-                rb_rotate_left(bst->parent->parent); // left rotation on grandparent
+                set_color(t, parent(t, bst), BLACK);          // set parent's color to black
+                set_color(t, parent(t, parent(t, bst)), RED); // set grandparent's color to red
+                rb_rotate_left(t, parent(t, parent(t, bst))); // left rotation on grandparent
             }
         }
     }
 
-    ROOT->color = BLACK;
+    set_color(t, t->root, BLACK);
 }
 
-void rb_rotate_left(NodePtr bst)
+void rb_rotate_left(RbTreePtr t, NodeIdx bst)
 {
-    // right rotation on bst node
-    NodePtr y;
+    // left rotation on bst node
+    NodeIdx y;
 
-    y = bst->right;       // y is bst's right child
-    bst->right = y->left; // bst's right child becomes y's left child
-    if (y->left != NILL)
-        y->left->parent = bst; // set the parent of y's left child to bst
+    y = node(t, bst)->right;                // y is bst's right child
+    node(t, bst)->right = node(t, y)->left; // bst's right child becomes y's left child
+    if (node(t, y)->left != NILL)
+        set_parent(t, node(t, y)->left, bst); // set the parent of y's left child to bst
 
-    y->parent = bst->parent; // y's parent becomes bst's parent
-    if (y->parent == NILL)   // if bst is the root
-        ROOT = y;
-    else if (bst == bst->parent->left) // if bst is bst's parent's left child
-        bst->parent->left = y;
+    NodeIdx p = parent(t, bst);
+    set_parent(t, y, p); // y's parent becomes bst's parent
+    if (p == NILL)       // if bst is the root
+        t->root = y;
+    else if (bst == node(t, p)->left) // if bst is bst's parent's left child
+        node(t, p)->left = y;
     else
-        bst->parent->right = y; // if bst is bst's parent's right child
+        node(t, p)->right = y; // if bst is bst's parent's right child
 
-    y->left = bst;   // y's left child becomes bst
-    bst->parent = y; // bst's parent becomes y
+    node(t, y)->left = bst; // y's left child becomes bst
+    set_parent(t, bst, y);  // bst's parent becomes y
+#if RB_ORDER_STATISTICS
+    node(t, y)->size = node(t, bst)->size; // y takes over bst's subtree
+    node(t, bst)->size = node(t, node(t, bst)->left)->size + node(t, node(t, bst)->right)->size + 1;
+#endif
 }
 
-void rb_rotate_right(NodePtr bst)
+void rb_rotate_right(RbTreePtr t, NodeIdx bst)
 {
-    NodePtr y;
+    NodeIdx y;
 
-    y = bst->left;        // y is bst's left child
-    bst->left = y->right; // bst's left child becomes y's right child
-    if (y->right != NILL)
-        y->right->parent = bst; // set the parent of y's right child to bst
+    y = node(t, bst)->left;                 // y is bst's left child
+    node(t, bst)->left = node(t, y)->right; // bst's left child becomes y's right child
+    if (node(t, y)->right != NILL)
+        set_parent(t, node(t, y)->right, bst); // set the parent of y's right child to bst
 
-    y->parent = bst->parent; // y's parent becomes bst's parent
-    if (y->parent == NILL)
-        ROOT = y;                      // if bst is the root
-    else if (bst == bst->parent->left) // if bst is bst's parent's left child
-        bst->parent->left = y;         // bst's parent's left child becomes y
+    NodeIdx p = parent(t, bst);
+    set_parent(t, y, p); // y's parent becomes bst's parent
+    if (p == NILL)
+        t->root = y;                  // if bst is the root
+    else if (bst == node(t, p)->left) // if bst is bst's parent's left child
+        node(t, p)->left = y;         // bst's parent's left child becomes y
     else
-        bst->parent->right = y; // bst's parent's right child becomes y
+        node(t, p)->right = y; // bst's parent's right child becomes y
 
-    y->right = bst;  // y's right child becomes bst
-    bst->parent = y; // bst's parent becomes y
+    node(t, y)->right = bst; // y's right child becomes bst
+    set_parent(t, bst, y);   // bst's parent becomes y
+#if RB_ORDER_STATISTICS
+    node(t, y)->size = node(t, bst)->size; // y takes over bst's subtree
+    node(t, bst)->size = node(t, node(t, bst)->left)->size + node(t, node(t, bst)->right)->size + 1;
+#endif
 }
 
-void rb_print(NodePtr bst)
+static void print_subtree(RbTreePtr t, NodeIdx bst, unsigned int depth)
 {
-    static unsigned int depth = 0; // depth of the current node, static variable
-    if (bst == NILL)               // if the current node is NILL
+    // depth is passed down instead of kept in a static variable, so trees can be printed from different threads
+    if (bst == NILL) // if the current node is NILL
         return;
-    ++depth;              // increase the depth
-    rb_print(bst->right); // recursive call on right nodes
-    --depth;              // reduce depth
+    print_subtree(t, node(t, bst)->right, depth + 1); // recursive call on right nodes
 
     for (unsigned int i = 0; i < depth; ++i)
         printf("  "); // print spaces
 
-    printf("%d\n", bst->key); // print the key of the current node
-    ++depth;                  // increase depth
-    rb_print(bst->left);      // recursive call on left nodes
-    --depth;                  // reduce depth
+    printf("%d\n", node(t, bst)->key);               // print the key of the current node
+    print_subtree(t, node(t, bst)->left, depth + 1); // recursive call on left nodes
+}
+
+void rb_print(RbTreePtr t)
+{
+    print_subtree(t, t->root, 0);
 }
 
-void rb_replace(NodePtr x, NodePtr y)
+void rb_replace(RbTreePtr t, NodeIdx x, NodeIdx y)
 {
     // switch the locations of x and y
-    if (x->parent == NILL)
+    NodeIdx p = parent(t, x);
+    if (p == NILL)
     {
         // if x is the root, y becomes the new root
-        ROOT = y;
+        t->root = y;
     }
-    else if (x == x->parent->left)
+    else if (x == node(t, p)->left)
     {
         // if x is x's parent's left child, y becomes x's parent's left child
-        x->parent->left = y;
+        node(t, p)->left = y;
     }
     else
     {
         // if x is x's parent's right child, y becomes x's parent's right child
-        x->parent->right = y;
+        node(t, p)->right = y;
     }
 
     // assign new parents
-    y->parent = x->parent;
+    set_parent(t, y, p);
 }
 
-NodePtr rb_successor(NodePtr bst)
+NodeIdx rb_successor(RbTreePtr t, NodeIdx bst)
 {
     // find the leftmost node (which is the minimum value node)
-    while (bst->left != NILL)
+    while (node(t, bst)->left != NILL)
     {
-        bst = bst->left; // reassignment
+        bst = node(t, bst)->left; // reassignment
     }
     return bst;
 }
 
-void rb_delete(int key)
+void rb_delete(RbTreePtr t, int key)
 {
-    NodePtr y, x;
+    NodeIdx y, x;
     int yOriginalColor; // original color of the y node
 
-    NodePtr bst = rb_search(ROOT, key); // search for the node to be deleted
-    y = bst;                            // temporarily store y node as bst root
-    yOriginalColor = y->color;          // assign color of y node
+    NodeIdx bst = rb_search(t, key); // search for the node to be deleted
+    if (bst == NILL)
+        return;                   // the key is not in the tree
+    y = bst;                      // temporarily store y node as bst root
+    yOriginalColor = color(t, y); // assign color of y node
+
+#if RB_ORDER_STATISTICS
+    // the node that leaves its place is bst, or its successor when bst has two children: every node above that place loses one descendant
+    NodeIdx removed = node(t, bst)->left != NILL && node(t, bst)->right != NILL ? rb_successor(t, node(t, bst)->right) : bst;
+    for (NodeIdx up = parent(t, removed); up != NILL; up = parent(t, up))
+        node(t, up)->size--;
+#endif
 
-    if (bst->left == NILL) // if there is no left child
+    if (node(t, bst)->left == NILL) // if there is no left child
     {
-        x = bst->right;              // x is bst's right child
-        rb_replace(bst, bst->right); // replace bst with bst's right child
+        x = node(t, bst)->right;                 // x is bst's right child
+        rb_replace(t, bst, node(t, bst)->right); // replace bst with bst's right child
     }
-    else if (bst->right == NILL) // if there is no right child
+    else if (node(t, bst)->right == NILL) // if there is no right child
     {
-        x = bst->left;              // x is bst's left child
-        rb_replace(bst, bst->left); // replace bst with bst's left child
+        x = node(t, bst)->left;                 // x is bst's left child
+        rb_replace(t, bst, node(t, bst)->left); // replace bst with bst's left child
     }
     else
     {
-        y = rb_successor(bst->right); // y is the successor of bst
-        yOriginalColor = y->color;    // assign color of y node
-        x = y->right;                 // x is y's right child
-        if (y->parent == bst)         // if y is bst's right child
-            x->parent = y;            // x's parent becomes y
+        y = rb_successor(t, node(t, bst)->right); // y is the successor of bst
+        yOriginalColor = color(t, y);             // assign color of y node
+        x = node(t, y)->right;                    // x is y's right child
+        if (parent(t, y) == bst)                  // if y is bst's right child
+            set_parent(t, x, y);                  // x's parent becomes y
         else
         {
-            rb_replace(y, y->right); // replace y with y's right child
-            y->right = bst->right;   // y's right child becomes bst's right child
-            y->right->parent = y;    // set the parent of y's right child to y
+            rb_replace(t, y, node(t, y)->right);     // replace y with y's right child
+            node(t, y)->right = node(t, bst)->right; // y's right child becomes bst's right child
+            set_parent(t, node(t, y)->right, y);     // set the parent of y's right child to y
         }
-        rb_replace(bst, y);    // replace bst with y
-        y->left = bst->left;   // y's left child becomes bst's left child
-        y->left->parent = y;   // set the parent of y's left child to y
-        y->color = bst->color; // y's color becomes bst's color
+        rb_replace(t, bst, y);                 // replace bst with y
+        node(t, y)->left = node(t, bst)->left; // y's left child becomes bst's left child
+        set_parent(t, node(t, y)->left, y);    // set the parent of y's left child to y
+        set_color(t, y, color(t, bst));        // y's color becomes bst's color
+#if RB_ORDER_STATISTICS
+        node(t, y)->size = node(t, bst)->size; // bst's size was already decreased, it is an ancestor of y's old place
+#endif
     }
 
+    pool_release(t, bst); // the node can be handed out again by the next insert
+
     if (yOriginalColor == BLACK)
-        rb_delete_fix(x); // fix the tree
+        rb_delete_fix(t, x); // fix the tree
 }
 
-void rb_delete_fix(NodePtr x)
+void rb_delete_fix(RbTreePtr t, NodeIdx x)
 {
-    NodePtr w;
+    NodeIdx w;
 
-    while (x != ROOT && x->color == BLACK) // while x is not the root and x is a black node
+    while (x != t->root && color(t, x) == BLACK) // while x is not the root and x is a black node
     {
-        if (x == x->parent->left) // if x is left child of parent
+        if (x == node(t, parent(t, x))->left) // if x is left child of parent
         {
-            w = x->parent->right; // w is x's parent's right child
-            if (w->color == RED)  // if w is red
+            w = node(t, parent(t, x))->right; // w is x's parent's right child
+            if (color(t, w) == RED)           // if w is red
             {
-                w->color = BLACK;          // w becomes black
-                x->parent->color = RED;    // x's parent becomes red
-                rb_rotate_left(x->parent); // rotate left on x's parent
-                w = x->parent->right;      // reassign w
+                set_color(t, w, BLACK);           // w becomes black
+                set_color(t, parent(t, x), RED);  // x's parent becomes red
+                rb_rotate_left(t, parent(t, x));  // rotate left on x's parent
+                w = node(t, parent(t, x))->right; // reassign w
             }
-            if (w->left->color == BLACK && w->right->color == BLACK) // if w's children are all black
+            if (color(t, node(t, w)->left) == BLACK && color(t, node(t, w)->right) == BLACK) // if w's children are all black
             {
-                w->color = RED; // w becomes red
-                x = x->parent;  // reassign x
+                set_color(t, w, RED); // w becomes red
+                x = parent(t, x);     // reassign x
             }
             else
             {
-                if (w->right->color == BLACK) // if w's right child is black
+                if (color(t, node(t, w)->right) == BLACK) // if w's right child is black
                 {
-                    w->left->color = BLACK; // w's left child becomes black
-                    w->color = RED;         // w becomes red
-                    rb_rotate_right(w);     // rotate right on w
-                    w = x->parent->right;   // reassign w
+                    set_color(t, node(t, w)->left, BLACK); // w's left child becomes black
+                    set_color(t, w, RED);                  // w becomes red
+                    rb_rotate_right(t, w);                 // rotate right on w
+                    w = node(t, parent(t, x))->right;      // reassign w
                 }
-                w->color = x->parent->color; // w's color becomes x's parent's color
-                x->parent->color = BLACK;    // x's parent becomes black
-                w->right->color = BLACK;     // w's right child becomes black
-                rb_rotate_left(x->parent);   // rotate left on x's parent
-                x = ROOT;                    // reassign x to be the new root
+                set_color(t, w, color(t, parent(t, x))); // w's color becomes x's parent's color
+                set_color(t, parent(t, x), BLACK);       // x's parent becomes black
+                set_color(t, node(t, w)->right, BLACK);  // w's right child becomes black
+                rb_rotate_left(t, parent(t, x));         // rotate left on x's parent
+                x = t->root;                             // reassign x to be the new root
             }
         }
         else
         {
-            w = x->parent->left; // w is x's parent's left child
-            if (w->color == RED) // if w is red
+            w = node(t, parent(t, x))->left; // w is x's parent's left child
+            if (color(t, w) == RED)          // if w is red
             {
-                w->color = BLACK;           // w becomes black
-                x->parent->color = RED;     // x's parent becomes red
-                rb_rotate_right(x->parent); // rotate right on x's parent
-                w = x->parent->left;        // reassign w
+                set_color(t, w, BLACK);           // w becomes black
+                set_color(t, parent(t, x), RED);  // x's parent becomes red
+                rb_rotate_right(t, parent(t, x)); // rotate right on x's parent
+                w = node(t, parent(t, x))->left;  // reassign w
             }
-            if (w->right->color == BLACK && w->left->color == BLACK) // if w's children are all black
+            if (color(t, node(t, w)->right) == BLACK && color(t, node(t, w)->left) == BLACK) // if w's children are all black
             {
-                w->color = RED; // w becomes red
-                x = x->parent;  // reassign x to be x's parent
+                set_color(t, w, RED); // w becomes red
+                x = parent(t, x);     // reassign x to be x's parent
             }
             else
             {
-                if (w->left->color == BLACK) // if w's left child is black
+                if (color(t, node(t, w)->left) == BLACK) // if w's left child is black
                 {
-                    w->right->color = BLACK; // w's right child becomes black
-                    w->color = RED;          // w becomes red
-                    rb_rotate_left(w);       // rotate left on w
-                    w = x->parent->left;     // reassign w
+                    set_color(t, node(t, w)->right, BLACK); // w's right child becomes black
+                    set_color(t, w, RED);                   // w becomes red
+                    rb_rotate_left(t, w);                   // rotate left on w
+                    w = node(t, parent(t, x))->left;        // reassign w
                 }
-                w->color = x->parent->color; // w's color becomes x's parent's color
-                x->parent->color = BLACK;    // x's parent becomes black
-                w->left->color = BLACK;      // w's left child becomes black
-                rb_rotate_right(x->parent);  // rotate right on x's parent
-                x = ROOT;                    // reassign x to be the new root
+                set_color(t, w, color(t, parent(t, x))); // w's color becomes x's parent's color
+                set_color(t, parent(t, x), BLACK);       // x's parent becomes black
+                set_color(t, node(t, w)->left, BLACK);   // w's left child becomes black
+                rb_rotate_right(t, parent(t, x));        // rotate right on x's parent
+                x = t->root;                             // reassign x to be the new root
             }
         }
     }
-    x->color = BLACK;
+    set_color(t, x, BLACK);
 }
 
-void destroy_bst(NodePtr *bstPtr)
+void destroy_bst(RbTreePtr *treePtr)
 {
-    // destroy the BST and free memory
-    NodePtr bst = *bstPtr;
-    if (bst != NILL)
+    // destroy the BST and free memory, every node is in the pool so there is only one block to free
+    RbTreePtr t = *treePtr;
+    free(t->nodes);
+    free(t);
+    *treePtr = NULL;
+}
+
+NodeIdx rb_search(RbTreePtr t, int key)
+{
+    // return the node that contains the key
+    NodeIdx bst = t->root;
+    while (bst != NILL && node(t, bst)->key != key)
+        bst = key < node(t, bst)->key ? node(t, bst)->left : node(t, bst)->right;
+    return bst;
+}
+
+int rb_key(RbTreePtr t, NodeIdx x)
+{
+    return node(t, x)->key;
+}
+
+NodeIdx rb_first(RbTreePtr t)
+{
+    // Time Complexity: O(log(n))
+    return t->root == NILL ? NILL : rb_successor(t, t->root);
+}
+
+NodeIdx rb_last(RbTreePtr t)
+{
+    // Time Complexity: O(log(n))
+    NodeIdx x = t->root;
+    if (x == NILL)
+        return NILL;
+    while (node(t, x)->right != NILL)
+        x = node(t, x)->right; // the rightmost node holds the largest key
+    return x;
+}
+
+NodeIdx rb_next(RbTreePtr t, NodeIdx x)
+{
+    /*
+        Time Complexity: O(log(n)) worst case, O(1) amortized over a full walk (every edge is crossed twice)
+        Space Complexity: O(1), the parent indices replace a stack
+    */
+    if (node(t, x)->right != NILL)
+        return rb_successor(t, node(t, x)->right); // leftmost node of the right subtree
+    NodeIdx p = parent(t, x);
+    while (p != NILL && x == node(t, p)->right)
     {
-        destroy_bst(&(bst->left));
-        destroy_bst(&(bst->right));
-        free(bst);
-        *bstPtr = NILL;
+        // climb until we come up from a left child, that parent is the next node
+        x = p;
+        p = parent(t, p);
     }
+    return p;
 }
 
-NodePtr rb_search(NodePtr root, int key)
+NodeIdx rb_prev(RbTreePtr t, NodeIdx x)
 {
-    // return the node that contains the key
-    if (root == NILL)
+    /*
+        Time Complexity: O(log(n)) worst case, O(1) amortized over a full walk
+        Space Complexity: O(1)
+    */
+    if (node(t, x)->left != NILL)
+    {
+        x = node(t, x)->left;
+        while (node(t, x)->right != NILL)
+            x = node(t, x)->right; // rightmost node of the left subtree
+        return x;
+    }
+    NodeIdx p = parent(t, x);
+    while (p != NILL && x == node(t, p)->left)
+    {
+        // climb until we come up from a right child
+        x = p;
+        p = parent(t, p);
+    }
+    return p;
+}
+
+NodeIdx rb_lower_bound(RbTreePtr t, int key)
+{
+    // Time Complexity: O(log(n))
+    NodeIdx bst = t->root, found = NILL;
+    while (bst != NILL)
+    {
+        if (node(t, bst)->key >= key)
+        {
+            found = bst; // a candidate, but there may be a smaller key >= key on the left (or an equal key, duplicates go left)
+            bst = node(t, bst)->left;
+        }
+        else
+            bst = node(t, bst)->right;
+    }
+    return found;
+}
+
+NodeIdx rb_upper_bound(RbTreePtr t, int key)
+{
+    // Time Complexity: O(log(n))
+    NodeIdx bst = t->root, found = NILL;
+    while (bst != NILL)
+    {
+        if (node(t, bst)->key > key)
+        {
+            found = bst;
+            bst = node(t, bst)->left;
+        }
+        else
+            bst = node(t, bst)->right;
+    }
+    return found;
+}
+
+long rb_range(RbTreePtr t, int lo, int hi, RbVisit visit, void *context)
+{
+    /*
+        Time Complexity: O(log(n) + k) for k keys in the range
+        Space Complexity: O(1)
+    */
+    long count = 0;
+    for (NodeIdx x = rb_lower_bound(t, lo); x != NILL && node(t, x)->key <= hi; x = rb_next(t, x))
+    {
+        visit(context, node(t, x)->key);
+        count++;
+    }
+    return count;
+}
+
+long rb_range_fill(RbTreePtr t, int lo, int hi, int *keys, long max)
+{
+    /*
+        Time Complexity: O(log(n) + k) for the k keys copied
+        Space Complexity: O(1)
+    */
+    long count = 0;
+    for (NodeIdx x = rb_lower_bound(t, lo); x != NILL && count < max && node(t, x)->key <= hi; x = rb_next(t, x))
+        keys[count++] = node(t, x)->key;
+    return count;
+}
+
+#if RB_ORDER_STATISTICS
+static long count_below(RbTreePtr t, int key, int inclusive)
+{
+    // number of keys < key, or <= key when inclusive
+    long count = 0;
+    NodeIdx bst = t->root;
+    while (bst != NILL)
+    {
+        if (node(t, bst)->key < key || (inclusive && node(t, bst)->key == key))
+        {
+            count += node(t, node(t, bst)->left)->size + 1; // bst and its whole left subtree are below key
+            bst = node(t, bst)->right;
+        }
+        else
+            bst = node(t, bst)->left;
+    }
+    return count;
+}
+
+long rb_rank(RbTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log(n))
+        Space Complexity: O(1)
+    */
+    return count_below(t, key, 0);
+}
+
+NodeIdx rb_select(RbTreePtr t, long k)
+{
+    /*
+        Time Complexity: O(log(n))
+        Space Complexity: O(1)
+    */
+    if (k < 0 || k >= node(t, t->root)->size)
         return NILL;
-    else if (root->key == key)
-        return root;
-    else if (key < root->key)
-        return rb_search(root->left, key);
-    else
-        return rb_search(root->right, key);
-}
\ No newline at end of file
+    NodeIdx bst = t->root;
+    while (1)
+    {
+        long left = node(t, node(t, bst)->left)->size;
+        if (k == left)
+            return bst; // exactly k keys are smaller
+        if (k < left)
+            bst = node(t, bst)->left;
+        else
+        {
+            k -= left + 1; // skip the left subtree and bst
+            bst = node(t, bst)->right;
+        }
+    }
+}
+
+long rb_count_range(RbTreePtr t, int lo, int hi)
+{
+    /*
+        Time Complexity: O(log(n)), two descents whatever the number of keys in the range
+        Space Complexity: O(1)
+    */
+    if (lo > hi)
+        return 0;
+    return count_below(t, hi, 1) - count_below(t, lo, 0);
+}
+#endif
+
+static NodeIdx build_subtree(RbTreePtr t, const int *keys, long lo, long hi, NodeIdx up, int depth, int red_depth)
+{
+    // keys[lo .. hi - 1] go below up; the key of keys[i] is stored in node i + 1, so the nodes are laid out in key order
+    if (lo >= hi)
+        return NILL;
+    long mid = lo + (hi - lo) / 2;
+    NodeIdx x = (NodeIdx)(mid + 1);
+    Node *nu = node(t, x);
+    nu->key = keys[mid];
+    nu->parent_color = (depth == red_depth ? COLOR_BIT : 0) | up;
+#if RB_ORDER_STATISTICS
+    nu->size = (uint32_t)(hi - lo);
+#endif
+    nu->left = build_subtree(t, keys, lo, mid, x, depth + 1, red_depth);
+    node(t, x)->right = build_subtree(t, keys, mid + 1, hi, x, depth + 1, red_depth);
+    return x;
+}
+
+RbTreePtr rb_build(const int *keys, long count)
+{
+    /*
+        Time Complexity: O(n), every node is written once and there are no rotations
+        Space Complexity: O(n) for the nodes, O(log(n)) for the recursion
+    */
+    if (count < 0 || count >= INDEX_MASK)
+        return NULL;
+    for (long i = 1; i < count; i++)
+        if (keys[i - 1] > keys[i])
+            return NULL; // not sorted
+
+    // splitting at the middle makes every level full except maybe the last one, whose nodes are made red:
+    // every path from the root to NILL then has the same number of black nodes, and no red node has a red child
+    RbTreePtr t = rb_create((uint32_t)count);
+    int full_levels = 0;
+    while ((2L << full_levels) - 1 <= count)
+        full_levels++; // levels 0 .. full_levels - 1 hold 2^full_levels - 1 nodes
+    t->root = build_subtree(t, keys, 0, count, NILL, 0, full_levels);
+    t->used = (uint32_t)count + 1;
+    return t;
+}
+
+RbTreePtr rb_merge(RbTreePtr a, RbTreePtr b)
+{
+    /*
+        Time Complexity: O(n + m), both trees are walked in order once and the result is built with rb_build
+        Space Complexity: O(n + m)
+    */
+    long capacity = (long)a->used + b->used; // at least the number of keys in both trees
+    int *keys = malloc(sizeof(int) * capacity);
+    long count = 0;
+    NodeIdx x = rb_first(a), y = rb_first(b);
+    while (x != NILL || y != NILL)
+    {
+        // take the smaller key of the two walks, like the merge step of merge sort
+        if (y == NILL || (x != NILL && node(a, x)->key <= node(b, y)->key))
+        {
+            keys[count++] = node(a, x)->key;
+            x = rb_next(a, x);
+        }
+        else
+        {
+            keys[count++] = node(b, y)->key;
+            y = rb_next(b, y);
+        }
+    }
+    RbTreePtr merged = rb_build(keys, count);
+    free(keys);
+    return merged;
+}
+
+static double seconds_since(struct timespec start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int rb_benchmark(int count)
+{
+    /*
+        Time Complexity: O(count * log(count))
+        Space Complexity: O(count)
+    */
+    if (count < 1)
+    {
+        printf("The number of keys must be positive\n");
+        return 1;
+    }
+    int *keys = malloc(sizeof(int) * count);
+    srand(42);
+    for (int i = 0; i < count; i++)
+        keys[i] = rand();
+
+    struct timespec start;
+    RbTreePtr t = rb_create(0); // let the pool grow, like a tree whose size is not known in advance
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_insert(t, keys[i]);
+    double insert_seconds = seconds_since(start);
+
+    long found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += rb_search(t, keys[(int)((long)i * 7919 % count)]) != NILL; // every key once, in a different order
+    double search_seconds = seconds_since(start);
+
+    // range scans, each covering about 100 keys
+    int width = (int)(100.0 * RAND_MAX / count);
+    int *scanned = malloc(sizeof(int) * 1000);
+    long numscanned = 0;
+    int numranges = count / 100 > 0 ? count / 100 : 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numranges; i++)
+    {
+        int lo = keys[i];
+        numscanned += rb_range_fill(t, lo, lo > RAND_MAX - width ? RAND_MAX : lo + width, scanned, 1000);
+    }
+    double range_seconds = seconds_since(start);
+    free(scanned);
+
+#if RB_ORDER_STATISTICS
+    // percentiles, each one a select and a rank
+    long checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+    {
+        NodeIdx percentile = rb_select(t, (long)(i % 100) * count / 100);
+        checksum += rb_rank(t, rb_key(t, percentile)) + rb_count_range(t, keys[i], keys[i]);
+    }
+    double order_seconds = seconds_since(start);
+#endif
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_delete(t, keys[i]);
+    double delete_seconds = seconds_since(start);
+
+    printf("%d keys, %zu bytes per node, pool of %u nodes\n", count, sizeof(Node), t->capacity);
+    printf("insert: %.3f s (%.0f ops/sec)\n", insert_seconds, count / insert_seconds);
+    printf("search: %.3f s (%.0f ops/sec), %ld found\n", search_seconds, count / search_seconds, found);
+    printf("range: %.3f s (%.0f scans/sec), %ld keys scanned\n", range_seconds, numranges / range_seconds, numscanned);
+#if RB_ORDER_STATISTICS
+    printf("select + rank + count: %.3f s (%.0f ops/sec), checksum %ld\n", order_seconds, count / order_seconds, checksum);
+#endif
+    printf("delete: %.3f s (%.0f ops/sec), %s left\n", delete_seconds, count / delete_seconds, t->root == NILL ? "nothing" : "nodes");
+
+    destroy_bst(&t);
+    free(keys);
+    return 0;
+}
+
+typedef struct shard_task
+{
+    RbTreePtr tree;  // the tree of this shard, only touched by this thread
+    const int *keys; // keys of this shard
+    int count;       // number of keys
+    long found;      // keys found again by the searches
+} ShardTask;
+
+static void *shard_worker(void *arg)
+{
+    ShardTask *task = arg;
+    for (int i = 0; i < task->count; i++)
+        rb_insert(task->tree, task->keys[i]);
+    for (int i = 0; i < task->count; i++)
+        task->found += rb_search(task->tree, task->keys[i]) != NILL;
+    return NULL;
+}
+
+int shard_benchmark(int count, int numthreads)
+{
+    /*
+        Time Complexity: O(count * log(count / numthreads) / numthreads) per thread
+        Space Complexity: O(count)
+    */
+    if (count < 1 || numthreads < 1)
+    {
+        printf("The number of keys and of threads must be positive\n");
+        return 1;
+    }
+    int *keys = malloc(sizeof(int) * count);
+    srand(42);
+    for (int i = 0; i < count; i++)
+        keys[i] = rand();
+
+    // key k belongs to shard k % numthreads, so a lookup knows which tree to search without asking the others
+    int *sharded = malloc(sizeof(int) * count);
+    int *starts = calloc(numthreads + 1, sizeof(int));
+    for (int i = 0; i < count; i++)
+        starts[keys[i] % numthreads + 1]++;
+    for (int s = 0; s < numthreads; s++)
+        starts[s + 1] += starts[s];
+    int *fill = malloc(sizeof(int) * numthreads);
+    memcpy(fill, starts, sizeof(int) * numthreads);
+    for (int i = 0; i < count; i++)
+        sharded[fill[keys[i] % numthreads]++] = keys[i];
+
+    // baseline: one tree, one thread
+    struct timespec start;
+    ShardTask single = {rb_create(0), keys, count, 0};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    shard_worker(&single);
+    double single_seconds = seconds_since(start);
+
+    // one tree per thread, the threads share nothing
+    ShardTask *tasks = malloc(sizeof(ShardTask) * numthreads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * numthreads);
+    for (int s = 0; s < numthreads; s++)
+    {
+        tasks[s].tree = rb_create(0);
+        tasks[s].keys = sharded + starts[s];
+        tasks[s].count = starts[s + 1] - starts[s];
+        tasks[s].found = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int s = 1; s < numthreads; s++)
+        pthread_create(&threads[s], NULL, shard_worker, &tasks[s]);
+    shard_worker(&tasks[0]); // the calling thread takes the first shard
+    for (int s = 1; s < numthreads; s++)
+        pthread_join(threads[s], NULL);
+    double sharded_seconds = seconds_since(start);
+
+    long found = 0;
+    for (int s = 0; s < numthreads; s++)
+    {
+        found += tasks[s].found;
+        destroy_bst(&tasks[s].tree);
+    }
+    printf("%d keys, insert + search\n", count);
+    printf("1 tree, 1 thread: %.3f s (%.0f ops/sec), %ld found\n", single_seconds, 2.0 * count / single_seconds, single.found);
+    printf("%d trees, %d threads: %.3f s (%.0f ops/sec), %ld found\n", numthreads, numthreads, sharded_seconds, 2.0 * count / sharded_seconds, found);
+
+    destroy_bst(&single.tree);
+    free(keys);
+    free(sharded);
+    free(starts);
+    free(fill);
+    free(tasks);
+    free(threads);
+    return 0;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int bulk_benchmark(int count)
+{
+    /*
+        Time Complexity: O(count * log(count))
+        Space Complexity: O(count)
+    */
+    if (count < 2)
+    {
+        printf("The number of keys must be at least 2\n");
+        return 1;
+    }
+    int *keys = malloc(sizeof(int) * count);
+    srand(42);
+    for (int i = 0; i < count; i++)
+        keys[i] = rand();
+    qsort(keys, count, sizeof(int), compare_ints);
+
+    // the whole index at once: n inserts against one build
+    struct timespec start;
+    RbTreePtr inserted = rb_create(0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_insert(inserted, keys[i]);
+    double insert_seconds = seconds_since(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RbTreePtr built = rb_build(keys, count);
+    double build_seconds = seconds_since(start);
+
+    // two halves (even and odd positions, so their keys interleave): inserting one into the other against a merge
+    int half = count / 2;
+    int *evens = malloc(sizeof(int) * (count - half));
+    int *odds = malloc(sizeof(int) * half);
+    for (int i = 0; i < count; i++)
+    {
+        if (i % 2 == 0)
+            evens[i / 2] = keys[i];
+        else
+            odds[i / 2] = keys[i];
+    }
+    RbTreePtr a = rb_build(evens, count - half), b = rb_build(odds, half);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RbTreePtr merged = rb_merge(a, b);
+    double merge_seconds = seconds_since(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (NodeIdx x = rb_first(b); x != NILL; x = rb_next(b, x))
+        rb_insert(a, rb_key(b, x));
+    double union_seconds = seconds_since(start);
+
+    // the built tree should be at least as fast to search as the inserted one, its nodes are in key order
+    long found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += rb_search(built, keys[(int)((long)i * 7919 % count)]) != NILL;
+    double search_seconds = seconds_since(start);
+
+    printf("%d sorted keys\n", count);
+    printf("insert one at a time: %.3f s\n", insert_seconds);
+    printf("rb_build: %.3f s (%.1fx faster)\n", build_seconds, insert_seconds / build_seconds);
+    printf("insert %d keys into a tree of %d: %.3f s\n", half, count - half, union_seconds);
+    printf("rb_merge: %.3f s (%.1fx faster)\n", merge_seconds, union_seconds / merge_seconds);
+    printf("search the built tree: %.3f s (%.0f ops/sec), %ld found\n", search_seconds, count / search_seconds, found);
+
+    destroy_bst(&inserted);
+    destroy_bst(&built);
+    destroy_bst(&merged);
+    destroy_bst(&a);
+    destroy_bst(&b);
+    free(keys);
+    free(evens);
+    free(odds);
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Demo and benchmark of the generated maps in rb_map.h
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * The demo counts words with a map from strings to their last position, where every repeated word only raises the count of its node.
+ * The benchmark times the same inserts and searches of random int keys on:
+ *     rbtree: the hand-written int tree in main.c
+ *     map: RB_MAP_DEFINE with RB_MAP_NUMERIC_CMP, the comparison is inlined
+ *     callback map: RB_MAP_DEFINE with a comparison called through a function pointer, like a map of void * keys with a comparator
+ * and then inserts keys with many repeats, to compare the nodes used by the tree (one per key) and by the map (one per distinct key).
+ *
+ * USAGE: ./map bench <number of keys>
+ */
+#define RB_NO_MAIN
+#include "main.c"
+#include "rb_map.h"
+
+int (*map_compare)(const void *, const void *) = compare_ints; // not static, so the compiler can't know it is always compare_ints
+#define CALLBACK_CMP(a, b) map_compare(&(a), &(b))
+
+RB_MAP_DEFINE(IntMap, int_map, int, int, RB_MAP_NUMERIC_CMP)
+RB_MAP_DEFINE(CallbackMap, callback_map, int, int, CALLBACK_CMP)
+RB_MAP_DEFINE(WordMap, word_map, const char *, int, strcmp)
+
+static int map_benchmark(int count)
+{
+    /*
+        Time Complexity: O(count * log(count))
+        Space Complexity: O(count)
+    */
+    if (count < 1)
+    {
+        printf("The number of keys must be positive\n");
+        return 1;
+    }
+    int *keys = malloc(sizeof(int) * count);
+    srand(42);
+    for (int i = 0; i < count; i++)
+        keys[i] = rand();
+    struct timespec start;
+    long found = 0;
+
+    RbTreePtr t = rb_create(0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        rb_insert(t, keys[i]);
+    double insert_seconds = seconds_since(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += rb_search(t, keys[(int)((long)i * 7919 % count)]) != NILL; // every key once, in a different order
+    double search_seconds = seconds_since(start);
+    printf("rbtree:       insert %.3f s (%.0f ops/sec), search %.3f s (%.0f ops/sec), %ld found\n",
+           insert_seconds, count / insert_seconds, search_seconds, count / search_seconds, found);
+    destroy_bst(&t);
+
+    found = 0;
+    IntMapPtr m = int_map_create(0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        int_map_insert(m, keys[i], i);
+    insert_seconds = seconds_since(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += int_map_get(m, keys[(int)((long)i * 7919 % count)]) != NULL;
+    search_seconds = seconds_since(start);
+    printf("map:          insert %.3f s (%.0f ops/sec), search %.3f s (%.0f ops/sec), %ld found\n",
+           insert_seconds, count / insert_seconds, search_seconds, count / search_seconds, found);
+    int_map_destroy(&m);
+
+    found = 0;
+    CallbackMapPtr c = callback_map_create(0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        callback_map_insert(c, keys[i], i);
+    insert_seconds = seconds_since(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        found += callback_map_get(c, keys[(int)((long)i * 7919 % count)]) != NULL;
+    search_seconds = seconds_since(start);
+    printf("callback map: insert %.3f s (%.0f ops/sec), search %.3f s (%.0f ops/sec), %ld found\n",
+           insert_seconds, count / insert_seconds, search_seconds, count / search_seconds, found);
+    callback_map_destroy(&c);
+
+    // every key 16 times over: the tree holds a node per copy, the map a node per distinct key
+    int distinct = count / 16 > 0 ? count / 16 : 1;
+    t = rb_create(0);
+    m = int_map_create(0);
+    for (int i = 0; i < count; i++)
+    {
+        rb_insert(t, keys[i % distinct]);
+        int_map_insert(m, keys[i % distinct], i);
+    }
+    printf("%d keys, %d distinct: rbtree %u nodes of %zu bytes, map %u nodes of %zu bytes (%ld keys)\n",
+           count, distinct, t->used - 1, sizeof(Node), m->used - 1, sizeof(IntMapNode), m->size);
+    destroy_bst(&t);
+    int_map_destroy(&m);
+
+    free(keys);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    // USAGE: ./map bench <number of keys>
+    // example: gcc -O2 -pthread map.c -o map; ./map bench 1000000
+    if (argc == 3 && strcmp(argv[1], "bench") == 0)
+        return map_benchmark(atoi(argv[2]));
+
+    const char *words[] = {"the", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog", "the", "end"};
+    int numwords = sizeof(words) / sizeof(words[0]);
+    WordMapPtr m = word_map_create(0); // create the map
+
+    for (int i = 0; i < numwords; i++)
+        word_map_insert(m, words[i], i); // a repeated word keeps its node, with its latest position
+
+    word_map_remove(m, "fox"); // the only copy, the node goes
+    word_map_remove(m, "the"); // one of three copies
+
+    printf("%ld words:\n", m->size);
+    for (uint32_t x = word_map_first(m); x != RB_MAP_NIL; x = word_map_next(m, x))
+        printf("%s x%u, last at %d\n", m->nodes[x].key, m->nodes[x].count, m->nodes[x].value);
+    int *position = word_map_get(m, "dog");
+    printf("dog is at %d, fox is %sin the map\n", position != NULL ? *position : -1, word_map_get(m, "fox") != NULL ? "" : "not ");
+
+    word_map_destroy(&m); // destroy the map
+    return 0;
+}
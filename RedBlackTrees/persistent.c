@@ -0,0 +1,592 @@
+// Persistent red-black tree in C: path copying updates, with snapshots for point-in-time reads
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * The tree in main.c changes its nodes in place, so a long scan either holds every writer off until it is done or sees a mix of old and new keys.
+ * Here a node is never changed once a version of the tree that contains it has been published:
+ *     - prb_insert and prb_delete copy the nodes on the path they touch (and the siblings they recolor), point the copies at the untouched subtrees,
+ *       and publish the new root with one pointer swap. Every other node is shared between the old version and the new one.
+ *     - prb_snapshot returns the current root as an immutable snapshot. Searches and scans on a snapshot take no lock at all and see exactly
+ *       the keys that were in the tree when it was taken, however many updates happen meanwhile.
+ *     - Nodes are reference counted (one reference per parent, per published root and per snapshot), so a node is freed as soon as
+ *       the last version that contains it is released, and releasing a snapshot only frees the nodes no newer version shares.
+ * The tree is a left-leaning red-black tree (Sedgewick): its recursive insert and delete return the new root of every subtree they change,
+ * which is exactly what path copying needs, while main.c's insert and delete climb parent pointers, which a shared node can't have.
+ * A node created by the current update belongs to it alone, so it is changed in place instead of being copied again.
+ * A key inserted again only raises the count of its node: the delete relies on every key having a single node, and repeated keys cost no extra nodes.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#define BLACK 0
+#define RED 1
+#define PRB_MAX_HEIGHT 128 // a left-leaning red-black tree of fewer than 2^63 nodes is never taller
+
+typedef struct pnode
+{
+    int key;             // the integer value stored
+    int color;           // RED or BLACK, the color of the link from the parent
+    int count;           // copies of key in the tree, at least 1
+    uint64_t stamp;      // update that created the node, it may only be changed in place during that update
+    atomic_int refs;     // parents, roots and snapshots pointing to the node
+    struct pnode *left;  // NULL for no child
+    struct pnode *right; // NULL for no child
+} PNode;
+typedef PNode *PNodePtr;
+
+typedef struct psnapshot
+{
+    PNodePtr root; // root of the version, NULL when it was empty
+    long size;     // number of keys in the version
+} PSnapshot;       // an immutable version of the tree, valid until prb_release
+
+typedef struct ptree
+{
+    PNodePtr root;          // root of the current version
+    long size;              // number of keys in the current version
+    uint64_t stamp;         // number of updates so far
+    pthread_mutex_t writer; // one update at a time
+    pthread_mutex_t swap;   // held only to publish a root or to take a reference to it
+    long copies;            // nodes allocated by updates, for the benchmark
+} PTree;
+typedef PTree *PTreePtr;
+typedef void (*PVisit)(void *context, int key); // called by prb_range for every key in the range, in increasing order
+
+PTreePtr prb_create(void);                                                       // create an empty tree
+void prb_destroy(PTreePtr *treePtr);                                             // destroy the tree, snapshots taken from it stay valid until released
+void prb_insert(PTreePtr t, int key);                                            // insert key, copying only the path to it
+bool prb_delete(PTreePtr t, int key);                                            // delete one copy of key, false if there was none
+PSnapshot prb_snapshot(PTreePtr t);                                              // the current version, never blocked by a scan
+void prb_release(PSnapshot *snapshot);                                           // release a snapshot, freeing the nodes only it still used
+bool prb_search(PSnapshot snapshot, int key);                                    // whether key was in the tree when the snapshot was taken
+long prb_range(PSnapshot snapshot, int lo, int hi, PVisit visit, void *context); // visit every key in [lo, hi], returns how many there were
+long prb_range_fill(PSnapshot snapshot, int lo, int hi, int *keys, long max);    // copy the first (at most max) keys in [lo, hi] to keys
+int persistent_benchmark(int count, long updates);                               // full scans of snapshots while a writer streams updates
+
+int main(int argc, char **argv)
+{
+    // USAGE: ./persistent bench <number of keys> <updates>
+    // example: gcc -O2 -pthread persistent.c -o persistent; ./persistent bench 1000000 1000000
+    if (argc == 4 && strcmp(argv[1], "bench") == 0)
+        return persistent_benchmark(atoi(argv[2]), atol(argv[3]));
+
+    PTreePtr t = prb_create(); // create the tree
+
+    // inserting nodes
+    for (int key = 10; key <= 50; key += 10)
+        prb_insert(t, key);
+    PSnapshot before = prb_snapshot(t); // 10 20 30 40 50
+
+    // deleting nodes
+    prb_delete(t, 20);
+    prb_delete(t, 10);
+    prb_insert(t, 60);
+    PSnapshot after = prb_snapshot(t); // 30 40 50 60
+
+    int keys[8];
+    long count = prb_range_fill(before, 0, 100, keys, 8);
+    printf("before: %ld keys:", count);
+    for (long i = 0; i < count; i++)
+        printf(" %d", keys[i]);
+    count = prb_range_fill(after, 0, 100, keys, 8);
+    printf("\nafter: %ld keys:", count);
+    for (long i = 0; i < count; i++)
+        printf(" %d", keys[i]);
+    printf("\n20 is %sin the first snapshot and %sin the second\n", prb_search(before, 20) ? "" : "not ", prb_search(after, 20) ? "" : "not ");
+
+    prb_release(&before);
+    prb_release(&after);
+    prb_destroy(&t); // destroy the tree
+    return 0;
+}
+
+static inline PNodePtr incref(PNodePtr x)
+{
+    if (x != NULL)
+        atomic_fetch_add_explicit(&x->refs, 1, memory_order_relaxed);
+    return x;
+}
+
+static void decref(PNodePtr x)
+{
+    /*
+        Time Complexity: O(1), plus O(1) for every node freed
+        Space Complexity: O(log(n)) for the recursion, only through nodes that are freed
+    */
+    while (x != NULL && atomic_fetch_sub_explicit(&x->refs, 1, memory_order_acq_rel) == 1)
+    {
+        // last reference: the node goes, and with it one reference to each child
+        PNodePtr left = x->left, right = x->right;
+        free(x);
+        decref(left);
+        x = right; // loop instead of recursing on the right child
+    }
+}
+
+static inline bool is_red(PNodePtr x)
+{
+    return x != NULL && x->color == RED;
+}
+
+static PNodePtr own(PTreePtr t, PNodePtr x)
+{
+    // a node of this update that may be changed in place; takes over the caller's reference to x
+    if (x == NULL || x->stamp == t->stamp)
+        return x;
+    PNodePtr copy = malloc(sizeof(PNode));
+    copy->key = x->key;
+    copy->color = x->color;
+    copy->count = x->count;
+    copy->stamp = t->stamp;
+    atomic_init(&copy->refs, 1);
+    copy->left = incref(x->left); // the children are now shared by x and its copy
+    copy->right = incref(x->right);
+    t->copies++;
+    decref(x); // still referenced by the version x came from
+    return copy;
+}
+
+static PNodePtr rotate_left(PTreePtr t, PNodePtr h)
+{
+    // h is owned; its right child becomes the root of the subtree
+    PNodePtr x = own(t, h->right);
+    h->right = x->left;
+    x->left = h;
+    x->color = h->color;
+    h->color = RED;
+    return x;
+}
+
+static PNodePtr rotate_right(PTreePtr t, PNodePtr h)
+{
+    PNodePtr x = own(t, h->left);
+    h->left = x->right;
+    x->right = h;
+    x->color = h->color;
+    h->color = RED;
+    return x;
+}
+
+static void flip_colors(PTreePtr t, PNodePtr h)
+{
+    // h is owned and has two children
+    h->left = own(t, h->left);
+    h->right = own(t, h->right);
+    h->color = !h->color;
+    h->left->color = !h->left->color;
+    h->right->color = !h->right->color;
+}
+
+static PNodePtr balance(PTreePtr t, PNodePtr h)
+{
+    // restore the left-leaning invariants at h on the way back up
+    if (is_red(h->right) && !is_red(h->left))
+        h = rotate_left(t, h);
+    if (is_red(h->left) && is_red(h->left->left))
+        h = rotate_right(t, h);
+    if (is_red(h->left) && is_red(h->right))
+        flip_colors(t, h);
+    return h;
+}
+
+static PNodePtr insert_subtree(PTreePtr t, PNodePtr h, int key)
+{
+    // insert key below h (whose reference is taken over), returns the new root of the subtree
+    if (h == NULL)
+    {
+        PNodePtr nu = malloc(sizeof(PNode)); // alloc memory for a new node
+        nu->key = key;
+        nu->color = RED; // a new node is always red
+        nu->count = 1;
+        nu->stamp = t->stamp;
+        atomic_init(&nu->refs, 1);
+        nu->left = nu->right = NULL;
+        t->copies++;
+        return nu;
+    }
+    h = own(t, h);
+    if (key == h->key)
+        h->count++; // the key is already here, the shape of the tree does not change
+    else if (key < h->key)
+        h->left = insert_subtree(t, h->left, key);
+    else
+        h->right = insert_subtree(t, h->right, key);
+    return balance(t, h);
+}
+
+static PNodePtr move_red_left(PTreePtr t, PNodePtr h)
+{
+    // make h->left or one of its children red before going left
+    flip_colors(t, h);
+    if (is_red(h->right->left))
+    {
+        h->right = rotate_right(t, h->right);
+        h = rotate_left(t, h);
+        flip_colors(t, h);
+    }
+    return h;
+}
+
+static PNodePtr move_red_right(PTreePtr t, PNodePtr h)
+{
+    flip_colors(t, h);
+    if (is_red(h->left->left))
+    {
+        h = rotate_right(t, h);
+        flip_colors(t, h);
+    }
+    return h;
+}
+
+static PNodePtr delete_min(PTreePtr t, PNodePtr h, PNodePtr into)
+{
+    // delete the smallest node below the owned h and move its key and count to into, returns the new root of the subtree
+    if (h->left == NULL)
+    {
+        into->key = h->key;
+        into->count = h->count;
+        decref(h); // a leaf, owned by this update only
+        return NULL;
+    }
+    if (!is_red(h->left) && !is_red(h->left->left))
+        h = move_red_left(t, h);
+    h->left = delete_min(t, own(t, h->left), into);
+    return balance(t, h);
+}
+
+static PNodePtr delete_subtree(PTreePtr t, PNodePtr h, int key)
+{
+    // delete the node with key value below the owned h, the key must be there
+    if (key < h->key)
+    {
+        if (!is_red(h->left) && !is_red(h->left->left))
+            h = move_red_left(t, h);
+        h->left = delete_subtree(t, own(t, h->left), key);
+    }
+    else
+    {
+        if (is_red(h->left))
+            h = rotate_right(t, h);
+        if (key == h->key && h->right == NULL)
+        {
+            decref(h); // a leaf, owned by this update only
+            return NULL;
+        }
+        if (!is_red(h->right) && !is_red(h->right->left))
+            h = move_red_right(t, h);
+        if (key == h->key)
+            h->right = delete_min(t, own(t, h->right), h); // h takes the key of its successor
+        else
+            h->right = delete_subtree(t, own(t, h->right), key);
+    }
+    return balance(t, h);
+}
+
+static PNodePtr decrement_subtree(PTreePtr t, PNodePtr h, int key)
+{
+    // copy the path to the node with key value (the key must be there more than once) and lower its count
+    h = own(t, h);
+    if (key == h->key)
+        h->count--;
+    else if (key < h->key)
+        h->left = decrement_subtree(t, h->left, key);
+    else
+        h->right = decrement_subtree(t, h->right, key);
+    return h;
+}
+
+static PNodePtr search_subtree(PNodePtr x, int key)
+{
+    while (x != NULL && x->key != key)
+        x = key < x->key ? x->left : x->right;
+    return x;
+}
+
+PTreePtr prb_create(void)
+{
+    /*
+        Time Complexity: O(1)
+        Space Complexity: O(1)
+    */
+    PTreePtr t = calloc(1, sizeof(PTree));
+    if (t == NULL)
+        return NULL; // just in case calloc failed
+    pthread_mutex_init(&t->writer, NULL);
+    pthread_mutex_init(&t->swap, NULL);
+    return t;
+}
+
+void prb_destroy(PTreePtr *treePtr)
+{
+    /*
+        Time Complexity: O(nodes only the current version uses)
+        Space Complexity: O(log(n))
+    */
+    PTreePtr t = *treePtr;
+    decref(t->root);
+    pthread_mutex_destroy(&t->writer);
+    pthread_mutex_destroy(&t->swap);
+    free(t);
+    *treePtr = NULL;
+}
+
+static void publish(PTreePtr t, PNodePtr root, long size)
+{
+    // make root the current version, the old one lives on in the snapshots that still hold it
+    pthread_mutex_lock(&t->swap);
+    PNodePtr old = t->root;
+    t->root = root;
+    t->size = size;
+    pthread_mutex_unlock(&t->swap);
+    decref(old); // outside the lock, freeing can take a while
+}
+
+void prb_insert(PTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log(n))
+        Space Complexity: O(log(n)) new nodes, the rest is shared with the previous version
+    */
+    pthread_mutex_lock(&t->writer);
+    t->stamp++; // nodes from earlier updates may be in snapshots now
+    PNodePtr root = insert_subtree(t, incref(t->root), key);
+    root->color = BLACK;
+    publish(t, root, t->size + 1);
+    pthread_mutex_unlock(&t->writer);
+}
+
+bool prb_delete(PTreePtr t, int key)
+{
+    /*
+        Time Complexity: O(log(n))
+        Space Complexity: O(log(n)) new nodes, the rest is shared with the previous version
+    */
+    pthread_mutex_lock(&t->writer);
+    PNodePtr x = search_subtree(t->root, key);
+    if (x == NULL)
+    {
+        pthread_mutex_unlock(&t->writer);
+        return false; // the key is not in the tree
+    }
+    t->stamp++;
+    PNodePtr root;
+    if (x->count > 1)
+        root = decrement_subtree(t, incref(t->root), key); // the node stays, only its count changes
+    else
+    {
+        root = own(t, incref(t->root));
+        if (!is_red(root->left) && !is_red(root->right))
+            root->color = RED;
+        root = delete_subtree(t, root, key);
+        if (root != NULL)
+            root->color = BLACK;
+    }
+    publish(t, root, t->size - 1);
+    pthread_mutex_unlock(&t->writer);
+    return true;
+}
+
+PSnapshot prb_snapshot(PTreePtr t)
+{
+    /*
+        Time Complexity: O(1), only waits for a root swap, never for an update or a scan
+        Space Complexity: O(1)
+    */
+    pthread_mutex_lock(&t->swap);
+    PSnapshot snapshot = {incref(t->root), t->size};
+    pthread_mutex_unlock(&t->swap);
+    return snapshot;
+}
+
+void prb_release(PSnapshot *snapshot)
+{
+    /*
+        Time Complexity: O(1), plus O(1) for every node that only this snapshot still used
+        Space Complexity: O(log(n))
+    */
+    decref(snapshot->root);
+    snapshot->root = NULL;
+    snapshot->size = 0;
+}
+
+bool prb_search(PSnapshot snapshot, int key)
+{
+    /*
+        Time Complexity: O(log(n))
+        Space Complexity: O(1)
+    */
+    return search_subtree(snapshot.root, key) != NULL;
+}
+
+long prb_range(PSnapshot snapshot, int lo, int hi, PVisit visit, void *context)
+{
+    /*
+        Time Complexity: O(log(n) + k) for the k keys in the range
+        Space Complexity: O(log(n)) for the stack of the walk, nodes have no parent pointers
+    */
+    PNodePtr stack[PRB_MAX_HEIGHT];
+    int depth = 0;
+    long count = 0;
+    PNodePtr x = snapshot.root;
+    while (x != NULL || depth > 0)
+    {
+        if (x != NULL)
+        {
+            if (x->key < lo)
+            {
+                x = x->right; // x and its left subtree are below the range
+                continue;
+            }
+            stack[depth++] = x;
+            x = x->left;
+        }
+        else
+        {
+            x = stack[--depth];
+            if (x->key > hi)
+                break; // every key from here on is above the range
+            for (int c = 0; c < x->count; c++)
+                visit(context, x->key); // once for every copy of the key
+            count += x->count;
+            x = x->right;
+        }
+    }
+    return count;
+}
+
+typedef struct fill_context
+{
+    int *keys;
+    long count;
+    long max;
+} FillContext;
+
+static void fill_visit(void *context, int key)
+{
+    FillContext *fill = context;
+    if (fill->count < fill->max)
+        fill->keys[fill->count++] = key;
+}
+
+long prb_range_fill(PSnapshot snapshot, int lo, int hi, int *keys, long max)
+{
+    /*
+        Time Complexity: O(log(n) + k) for the k keys in the range
+        Space Complexity: O(log(n))
+    */
+    FillContext fill = {keys, 0, max};
+    prb_range(snapshot, lo, hi, fill_visit, &fill);
+    return fill.count;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct scan_state
+{
+    long count;    // keys visited
+    long previous; // last key visited
+    bool ordered;  // every key so far was from a later pair {2i, 2i + 1} than the one before
+} ScanState;
+
+static void scan_visit(void *context, int key)
+{
+    ScanState *scan = context;
+    scan->ordered = scan->ordered && key / 2 > scan->previous / 2;
+    scan->previous = key;
+    scan->count++;
+}
+
+typedef struct scanner_task
+{
+    PTreePtr t;
+    atomic_bool *done; // set once the writer has finished
+    int count;         // pairs of keys
+    long scans;        // full scans done
+    long keys;         // keys visited by all of them
+    long violations;   // scans that did not see exactly the keys of their snapshot, must stay 0
+} ScannerTask;
+
+static void *scanner_worker(void *arg)
+{
+    // scan whole snapshots while the writer works: every version holds one key of each pair, except the pair an update is moving
+    ScannerTask *task = arg;
+    task->scans = task->keys = task->violations = 0;
+    while (!atomic_load_explicit(task->done, memory_order_relaxed))
+    {
+        PSnapshot snapshot = prb_snapshot(task->t);
+        ScanState scan = {0, -2, true};
+        prb_range(snapshot, INT32_MIN, INT32_MAX, scan_visit, &scan);
+        task->violations += !scan.ordered || scan.count != snapshot.size || scan.count < task->count - 1;
+        task->scans++;
+        task->keys += scan.count;
+        prb_release(&snapshot);
+    }
+    return NULL;
+}
+
+int persistent_benchmark(int count, long updates)
+{
+    /*
+        Time Complexity: O((count + updates) * log(count)), plus the scans
+        Space Complexity: O(count + log(count) * snapshots held)
+    */
+    if (count < 1)
+        count = 1;
+    printf("keys %d | updates %ld\n", count, updates);
+    PTreePtr t = prb_create();
+    double start = now_seconds();
+    for (int i = 0; i < count; i++)
+        prb_insert(t, 2 * i); // even keys
+    printf("insert: %.3f s\n", now_seconds() - start);
+
+    // every update moves one key to the other key of its pair: 2i becomes 2i + 1 and back
+    int *keys = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++)
+        keys[i] = 2 * i;
+    PSnapshot frozen = prb_snapshot(t);
+    atomic_bool done;
+    atomic_init(&done, false);
+    ScannerTask task = {t, &done, count, 0, 0, 0};
+    pthread_t scanner;
+    pthread_create(&scanner, NULL, scanner_worker, &task);
+
+    srand(42);
+    long copies = t->copies;
+    start = now_seconds();
+    for (long i = 0; i < updates; i++)
+    {
+        int k = rand() % count;
+        prb_delete(t, keys[k]);
+        keys[k] += 1 - 2 * (keys[k] & 1); // 2i <-> 2i + 1
+        prb_insert(t, keys[k]);
+    }
+    double elapsed = now_seconds() - start;
+    atomic_store(&done, true);
+    pthread_join(scanner, NULL);
+    printf("updates: %.3f s | %.0f updates/s | %.1f nodes copied per update\n", elapsed, updates / elapsed, (double)(t->copies - copies) / (updates > 0 ? updates : 1));
+    printf("scans during the updates: %ld (%ld keys) | wrong scans: %ld\n", task.scans, task.keys, task.violations);
+
+    // the snapshot taken before the updates still holds exactly the even keys
+    long even = 0;
+    for (int i = 0; i < count; i++)
+        even += prb_search(frozen, 2 * i);
+    printf("snapshot from before the updates: %ld of %d keys\n", even, count);
+    prb_release(&frozen);
+
+    free(keys);
+    prb_destroy(&t);
+    return task.violations == 0 && even == count ? 0 : 1;
+}
@@ -0,0 +1,437 @@
+// Generic red-black map in C: one specialized map per key type, value type and comparison, generated by a macro
+// Author: Ganning Xu, NCSSM
+/* DESCRIPTION:
+ * The tree in main.c only stores int keys. Storing other keys through void * and a comparison callback would cost an indirect call
+ * at every level of every search, which the compiler can't inline. Instead, like a C++ template, RB_MAP_DEFINE writes the whole map
+ * for one key type K, one value type V and one comparison CMP, so the comparison is inlined into the descent and a map of int keys
+ * searches as fast as the hand-written tree:
+ *     RB_MAP_DEFINE(IntMap, int_map, int, double, RB_MAP_NUMERIC_CMP)
+ * defines the types IntMap and IntMapPtr and the functions int_map_create, int_map_insert, int_map_get, int_map_count, int_map_remove,
+ * int_map_first, int_map_next and int_map_destroy. CMP(a, b) is a function-like macro or a function returning < 0, 0 or > 0, like strcmp.
+ * The map works like main.c: nodes live in one pool and refer to each other by 32-bit index, the color is in the top bit of the parent index,
+ * and the insert and delete are the same algorithms. Inserting a key that is already in the map does not add a node but raises the count of its node
+ * (and replaces its value), so repeated keys cost no memory and every search stops at the only node of its key.
+ * Every generated function is static inline, so every file that includes the header gets its own copy. This is unlike bptree.h, whose public functions have external linkage and can only be included from one file per program.
+ *
+ * Time Complexity of each function is located in the definition of the function.
+ * The space complexity of each function is also located in the definition of the function.
+ */
+#ifndef RB_MAP_H
+#define RB_MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RB_MAP_NIL 0                  // index of the NILL node, the first node of every pool
+#define RB_MAP_COLOR_BIT 0x80000000u  // red nodes have the top bit of parent_color set
+#define RB_MAP_INDEX_MASK 0x7fffffffu // the other 31 bits hold the parent's index
+// CMP for any type with == and <. Written with conditionals rather than ((a) > (b)) - ((a) < (b)), so that after inlining the compiler
+// merges the three way result and the tests on it in the descent into one compare, and the search compiles to the same loop as rb_search in main.c
+#define RB_MAP_NUMERIC_CMP(a, b) ((a) == (b) ? 0 : (a) < (b) ? -1 : 1)
+
+#define RB_MAP_DEFINE(Map, prefix, K, V, CMP)                                                                         \
+typedef struct                                                                                                        \
+{                                                                                                                     \
+    K key;                                                                                                            \
+    V value;                                                                                                          \
+    uint32_t left;                                                                                                    \
+    uint32_t right;                                                                                                   \
+    uint32_t parent_color; /* index of the parent, with the color in the top bit */                                   \
+    uint32_t count;        /* copies of key in the map, at least 1 */                                                 \
+} Map##Node;                                                                                                          \
+                                                                                                                      \
+typedef struct                                                                                                        \
+{                                                                                                                     \
+    uint32_t root;     /* root of the tree, RB_MAP_NIL when the map is empty */                                       \
+    Map##Node *nodes;  /* every node of the map, nodes[RB_MAP_NIL] is the NILL node */                                \
+    uint32_t capacity; /* number of nodes allocated */                                                                \
+    uint32_t used;     /* nodes handed out at least once, including NILL */                                           \
+    uint32_t free;     /* most recently released node, released nodes are chained through left */                     \
+    long size;         /* number of keys, counting every copy */                                                      \
+} Map;                                                                                                                \
+typedef Map *Map##Ptr;                                                                                                \
+                                                                                                                      \
+static inline uint32_t prefix##_parent(Map##Ptr m, uint32_t x)                                                        \
+{                                                                                                                     \
+    return m->nodes[x].parent_color & RB_MAP_INDEX_MASK;                                                              \
+}                                                                                                                     \
+                                                                                                                      \
+static inline int prefix##_color(Map##Ptr m, uint32_t x)                                                              \
+{                                                                                                                     \
+    return m->nodes[x].parent_color >> 31;                                                                            \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_set_parent(Map##Ptr m, uint32_t x, uint32_t p)                                            \
+{                                                                                                                     \
+    m->nodes[x].parent_color = (m->nodes[x].parent_color & RB_MAP_COLOR_BIT) | p;                                     \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_set_color(Map##Ptr m, uint32_t x, int c)                                                  \
+{                                                                                                                     \
+    m->nodes[x].parent_color = (m->nodes[x].parent_color & RB_MAP_INDEX_MASK) | ((uint32_t)c << 31);                  \
+}                                                                                                                     \
+                                                                                                                      \
+static inline Map##Ptr prefix##_create(uint32_t capacity)                                                             \
+{                                                                                                                     \
+    /*                                                                                                                \
+        Time Complexity: O(1)                                                                                         \
+        Space Complexity: O(capacity)                                                                                 \
+    */                                                                                                                \
+    Map##Ptr m = malloc(sizeof(Map));                                                                                 \
+    m->capacity = capacity + 1; /* one more for the NILL node */                                                      \
+    m->nodes = malloc(sizeof(Map##Node) * m->capacity);                                                               \
+    memset(&m->nodes[RB_MAP_NIL], 0, sizeof(Map##Node)); /* NILL is black and points nowhere */                       \
+    m->used = 1;                                                                                                      \
+    m->free = RB_MAP_NIL;                                                                                             \
+    m->root = RB_MAP_NIL;                                                                                             \
+    m->size = 0;                                                                                                      \
+    return m;                                                                                                         \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_destroy(Map##Ptr *mapPtr)                                                                 \
+{                                                                                                                     \
+    free((*mapPtr)->nodes);                                                                                           \
+    free(*mapPtr);                                                                                                    \
+    *mapPtr = NULL;                                                                                                   \
+}                                                                                                                     \
+                                                                                                                      \
+static inline uint32_t prefix##_find(Map##Ptr m, K key)                                                               \
+{                                                                                                                     \
+    /*                                                                                                                \
+        Time Complexity: O(log(n)), with CMP inlined at every level                                                   \
+        Space Complexity: O(1)                                                                                        \
+    */                                                                                                                \
+    const Map##Node *nodes = m->nodes;                                                                                \
+    uint32_t x = m->root;                                                                                             \
+    while (x != RB_MAP_NIL)                                                                                           \
+    {                                                                                                                 \
+        int c = CMP(key, nodes[x].key);                                                                               \
+        if (c == 0)                                                                                                   \
+            break;                                                                                                    \
+        x = c < 0 ? nodes[x].left : nodes[x].right;                                                                   \
+    }                                                                                                                 \
+    return x;                                                                                                         \
+}                                                                                                                     \
+                                                                                                                      \
+static inline V *prefix##_get(Map##Ptr m, K key)                                                                      \
+{                                                                                                                     \
+    /* the value stored with key, NULL if key is not in the map; valid until the next insert */                       \
+    uint32_t x = prefix##_find(m, key);                                                                               \
+    return x == RB_MAP_NIL ? NULL : &m->nodes[x].value;                                                               \
+}                                                                                                                     \
+                                                                                                                      \
+static inline long prefix##_count(Map##Ptr m, K key)                                                                  \
+{                                                                                                                     \
+    /* how many times key is in the map */                                                                            \
+    return m->nodes[prefix##_find(m, key)].count; /* NILL has a count of 0 */                                         \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_rotate_left(Map##Ptr m, uint32_t x)                                                       \
+{                                                                                                                     \
+    Map##Node *n = m->nodes;                                                                                          \
+    uint32_t y = n[x].right;                                                                                          \
+    n[x].right = n[y].left;                                                                                           \
+    if (n[y].left != RB_MAP_NIL)                                                                                      \
+        prefix##_set_parent(m, n[y].left, x);                                                                         \
+    uint32_t p = prefix##_parent(m, x);                                                                               \
+    prefix##_set_parent(m, y, p);                                                                                     \
+    if (p == RB_MAP_NIL)                                                                                              \
+        m->root = y;                                                                                                  \
+    else if (x == n[p].left)                                                                                          \
+        n[p].left = y;                                                                                                \
+    else                                                                                                              \
+        n[p].right = y;                                                                                               \
+    n[y].left = x;                                                                                                    \
+    prefix##_set_parent(m, x, y);                                                                                     \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_rotate_right(Map##Ptr m, uint32_t x)                                                      \
+{                                                                                                                     \
+    Map##Node *n = m->nodes;                                                                                          \
+    uint32_t y = n[x].left;                                                                                           \
+    n[x].left = n[y].right;                                                                                           \
+    if (n[y].right != RB_MAP_NIL)                                                                                     \
+        prefix##_set_parent(m, n[y].right, x);                                                                        \
+    uint32_t p = prefix##_parent(m, x);                                                                               \
+    prefix##_set_parent(m, y, p);                                                                                     \
+    if (p == RB_MAP_NIL)                                                                                              \
+        m->root = y;                                                                                                  \
+    else if (x == n[p].right)                                                                                         \
+        n[p].right = y;                                                                                               \
+    else                                                                                                              \
+        n[p].left = y;                                                                                                \
+    n[y].right = x;                                                                                                   \
+    prefix##_set_parent(m, x, y);                                                                                     \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_insert_fix(Map##Ptr m, uint32_t z)                                                        \
+{                                                                                                                     \
+    /* same cases as rb_insert_fix in main.c */                                                                       \
+    Map##Node *n = m->nodes;                                                                                          \
+    while (prefix##_color(m, prefix##_parent(m, z)) == 1)                                                             \
+    {                                                                                                                 \
+        uint32_t p = prefix##_parent(m, z), g = prefix##_parent(m, p);                                                \
+        uint32_t uncle = p == n[g].left ? n[g].right : n[g].left;                                                     \
+        if (prefix##_color(m, uncle) == 1)                                                                            \
+        {                                                                                                             \
+            prefix##_set_color(m, p, 0);                                                                              \
+            prefix##_set_color(m, uncle, 0);                                                                          \
+            prefix##_set_color(m, g, 1);                                                                              \
+            z = g;                                                                                                    \
+        }                                                                                                             \
+        else if (p == n[g].left)                                                                                      \
+        {                                                                                                             \
+            if (z == n[p].right)                                                                                      \
+            {                                                                                                         \
+                z = p;                                                                                                \
+                prefix##_rotate_left(m, z);                                                                           \
+            }                                                                                                         \
+            prefix##_set_color(m, prefix##_parent(m, z), 0);                                                          \
+            prefix##_set_color(m, g, 1);                                                                              \
+            prefix##_rotate_right(m, g);                                                                              \
+        }                                                                                                             \
+        else                                                                                                          \
+        {                                                                                                             \
+            if (z == n[p].left)                                                                                       \
+            {                                                                                                         \
+                z = p;                                                                                                \
+                prefix##_rotate_right(m, z);                                                                          \
+            }                                                                                                         \
+            prefix##_set_color(m, prefix##_parent(m, z), 0);                                                          \
+            prefix##_set_color(m, g, 1);                                                                              \
+            prefix##_rotate_left(m, g);                                                                               \
+        }                                                                                                             \
+    }                                                                                                                 \
+    prefix##_set_color(m, m->root, 0);                                                                                \
+}                                                                                                                     \
+                                                                                                                      \
+static inline V *prefix##_insert(Map##Ptr m, K key, V value)                                                          \
+{                                                                                                                     \
+    /*                                                                                                                \
+        Time Complexity: O(log(n)) amortized, the pool doubles when it is full                                        \
+        Space Complexity: O(1) amortized, nothing when key is already in the map                                      \
+        adds one copy of key and stores value with it; returns where the value is, NULL if the pool could not grow    \
+    */                                                                                                                \
+    uint32_t x = m->root, p = RB_MAP_NIL;                                                                             \
+    int c = 0;                                                                                                        \
+    while (x != RB_MAP_NIL)                                                                                           \
+    {                                                                                                                 \
+        c = CMP(key, m->nodes[x].key);                                                                                \
+        if (c == 0)                                                                                                   \
+        {                                                                                                             \
+            m->nodes[x].count++; /* one more copy, the shape of the tree does not change */                           \
+            m->nodes[x].value = value;                                                                                \
+            m->size++;                                                                                                \
+            return &m->nodes[x].value;                                                                                \
+        }                                                                                                             \
+        p = x;                                                                                                        \
+        x = c < 0 ? m->nodes[x].left : m->nodes[x].right;                                                             \
+    }                                                                                                                 \
+                                                                                                                      \
+    uint32_t z = m->free;                                                                                             \
+    if (z != RB_MAP_NIL)                                                                                              \
+        m->free = m->nodes[z].left; /* reuse the most recently released node */                                       \
+    else                                                                                                              \
+    {                                                                                                                 \
+        if (m->used == m->capacity)                                                                                   \
+        {                                                                                                             \
+            if (m->capacity > RB_MAP_INDEX_MASK / 2)                                                                  \
+                return NULL; /* the parent index has no room for more nodes */                                        \
+            uint32_t capacity = m->capacity < 16 ? 16 : m->capacity * 2;                                              \
+            Map##Node *nodes = realloc(m->nodes, sizeof(Map##Node) * capacity);                                       \
+            if (nodes == NULL)                                                                                        \
+                return NULL;                                                                                          \
+            m->nodes = nodes;                                                                                         \
+            m->capacity = capacity;                                                                                   \
+        }                                                                                                             \
+        z = m->used++;                                                                                                \
+    }                                                                                                                 \
+    Map##Node *n = m->nodes;                                                                                          \
+    n[z].key = key;                                                                                                   \
+    n[z].value = value;                                                                                               \
+    n[z].count = 1;                                                                                                   \
+    n[z].left = n[z].right = RB_MAP_NIL;                                                                              \
+    n[z].parent_color = RB_MAP_COLOR_BIT | p; /* new nodes are red */                                                 \
+    if (p == RB_MAP_NIL)                                                                                              \
+        m->root = z;                                                                                                  \
+    else if (c < 0)                                                                                                   \
+        n[p].left = z;                                                                                                \
+    else                                                                                                              \
+        n[p].right = z;                                                                                               \
+    m->size++;                                                                                                        \
+    prefix##_insert_fix(m, z);                                                                                        \
+    return &n[z].value;                                                                                               \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_replace(Map##Ptr m, uint32_t x, uint32_t y)                                               \
+{                                                                                                                     \
+    /* put y where x is */                                                                                            \
+    uint32_t p = prefix##_parent(m, x);                                                                               \
+    if (p == RB_MAP_NIL)                                                                                              \
+        m->root = y;                                                                                                  \
+    else if (x == m->nodes[p].left)                                                                                   \
+        m->nodes[p].left = y;                                                                                         \
+    else                                                                                                              \
+        m->nodes[p].right = y;                                                                                        \
+    prefix##_set_parent(m, y, p);                                                                                     \
+}                                                                                                                     \
+                                                                                                                      \
+static inline void prefix##_delete_fix(Map##Ptr m, uint32_t x)                                                        \
+{                                                                                                                     \
+    /* same cases as rb_delete_fix in main.c */                                                                       \
+    Map##Node *n = m->nodes;                                                                                          \
+    while (x != m->root && prefix##_color(m, x) == 0)                                                                 \
+    {                                                                                                                 \
+        uint32_t p = prefix##_parent(m, x);                                                                           \
+        if (x == n[p].left)                                                                                           \
+        {                                                                                                             \
+            uint32_t w = n[p].right;                                                                                  \
+            if (prefix##_color(m, w) == 1)                                                                            \
+            {                                                                                                         \
+                prefix##_set_color(m, w, 0);                                                                          \
+                prefix##_set_color(m, p, 1);                                                                          \
+                prefix##_rotate_left(m, p);                                                                           \
+                w = n[p].right;                                                                                       \
+            }                                                                                                         \
+            if (prefix##_color(m, n[w].left) == 0 && prefix##_color(m, n[w].right) == 0)                              \
+            {                                                                                                         \
+                prefix##_set_color(m, w, 1);                                                                          \
+                x = p;                                                                                                \
+            }                                                                                                         \
+            else                                                                                                      \
+            {                                                                                                         \
+                if (prefix##_color(m, n[w].right) == 0)                                                               \
+                {                                                                                                     \
+                    prefix##_set_color(m, n[w].left, 0);                                                              \
+                    prefix##_set_color(m, w, 1);                                                                      \
+                    prefix##_rotate_right(m, w);                                                                      \
+                    w = n[p].right;                                                                                   \
+                }                                                                                                     \
+                prefix##_set_color(m, w, prefix##_color(m, p));                                                       \
+                prefix##_set_color(m, p, 0);                                                                          \
+                prefix##_set_color(m, n[w].right, 0);                                                                 \
+                prefix##_rotate_left(m, p);                                                                           \
+                x = m->root;                                                                                          \
+            }                                                                                                         \
+        }                                                                                                             \
+        else                                                                                                          \
+        {                                                                                                             \
+            uint32_t w = n[p].left;                                                                                   \
+            if (prefix##_color(m, w) == 1)                                                                            \
+            {                                                                                                         \
+                prefix##_set_color(m, w, 0);                                                                          \
+                prefix##_set_color(m, p, 1);                                                                          \
+                prefix##_rotate_right(m, p);                                                                          \
+                w = n[p].left;                                                                                        \
+            }                                                                                                         \
+            if (prefix##_color(m, n[w].right) == 0 && prefix##_color(m, n[w].left) == 0)                              \
+            {                                                                                                         \
+                prefix##_set_color(m, w, 1);                                                                          \
+                x = p;                                                                                                \
+            }                                                                                                         \
+            else                                                                                                      \
+            {                                                                                                         \
+                if (prefix##_color(m, n[w].left) == 0)                                                                \
+                {                                                                                                     \
+                    prefix##_set_color(m, n[w].right, 0);                                                             \
+                    prefix##_set_color(m, w, 1);                                                                      \
+                    prefix##_rotate_left(m, w);                                                                       \
+                    w = n[p].left;                                                                                    \
+                }                                                                                                     \
+                prefix##_set_color(m, w, prefix##_color(m, p));                                                       \
+                prefix##_set_color(m, p, 0);                                                                          \
+                prefix##_set_color(m, n[w].left, 0);                                                                  \
+                prefix##_rotate_right(m, p);                                                                          \
+                x = m->root;                                                                                          \
+            }                                                                                                         \
+        }                                                                                                             \
+    }                                                                                                                 \
+    prefix##_set_color(m, x, 0);                                                                                      \
+}                                                                                                                     \
+                                                                                                                      \
+static inline bool prefix##_remove(Map##Ptr m, K key)                                                                 \
+{                                                                                                                     \
+    /*                                                                                                                \
+        Time Complexity: O(log(n))                                                                                    \
+        Space Complexity: O(1)                                                                                        \
+        removes one copy of key, and its node with the last copy; false if key is not in the map                      \
+    */                                                                                                                \
+    uint32_t z = prefix##_find(m, key);                                                                               \
+    if (z == RB_MAP_NIL)                                                                                              \
+        return false;                                                                                                 \
+    m->size--;                                                                                                        \
+    Map##Node *n = m->nodes;                                                                                          \
+    if (--n[z].count > 0)                                                                                             \
+        return true;                                                                                                  \
+                                                                                                                      \
+    uint32_t y = z, x;                                                                                                \
+    int yOriginalColor = prefix##_color(m, y);                                                                        \
+    if (n[z].left == RB_MAP_NIL)                                                                                      \
+    {                                                                                                                 \
+        x = n[z].right;                                                                                               \
+        prefix##_replace(m, z, x);                                                                                    \
+    }                                                                                                                 \
+    else if (n[z].right == RB_MAP_NIL)                                                                                \
+    {                                                                                                                 \
+        x = n[z].left;                                                                                                \
+        prefix##_replace(m, z, x);                                                                                    \
+    }                                                                                                                 \
+    else                                                                                                              \
+    {                                                                                                                 \
+        y = n[z].right; /* the successor of z */                                                                      \
+        while (n[y].left != RB_MAP_NIL)                                                                               \
+            y = n[y].left;                                                                                            \
+        yOriginalColor = prefix##_color(m, y);                                                                        \
+        x = n[y].right;                                                                                               \
+        if (prefix##_parent(m, y) == z)                                                                               \
+            prefix##_set_parent(m, x, y);                                                                             \
+        else                                                                                                          \
+        {                                                                                                             \
+            prefix##_replace(m, y, n[y].right);                                                                       \
+            n[y].right = n[z].right;                                                                                  \
+            prefix##_set_parent(m, n[y].right, y);                                                                    \
+        }                                                                                                             \
+        prefix##_replace(m, z, y);                                                                                    \
+        n[y].left = n[z].left;                                                                                        \
+        prefix##_set_parent(m, n[y].left, y);                                                                         \
+        prefix##_set_color(m, y, prefix##_color(m, z));                                                               \
+    }                                                                                                                 \
+    n[z].left = m->free; /* the node can be handed out again by the next insert */                                    \
+    m->free = z;                                                                                                      \
+    if (yOriginalColor == 0)                                                                                          \
+        prefix##_delete_fix(m, x);                                                                                    \
+    return true;                                                                                                      \
+}                                                                                                                     \
+                                                                                                                      \
+static inline uint32_t prefix##_first(Map##Ptr m)                                                                     \
+{                                                                                                                     \
+    /* node with the smallest key, RB_MAP_NIL if the map is empty; read it with m->nodes[x].key, .value and .count */ \
+    uint32_t x = m->root;                                                                                             \
+    while (x != RB_MAP_NIL && m->nodes[x].left != RB_MAP_NIL)                                                         \
+        x = m->nodes[x].left;                                                                                         \
+    return x;                                                                                                         \
+}                                                                                                                     \
+                                                                                                                      \
+static inline uint32_t prefix##_next(Map##Ptr m, uint32_t x)                                                          \
+{                                                                                                                     \
+    /* node after x in key order, RB_MAP_NIL after the last one */                                                    \
+    if (m->nodes[x].right != RB_MAP_NIL)                                                                              \
+    {                                                                                                                 \
+        x = m->nodes[x].right;                                                                                        \
+        while (m->nodes[x].left != RB_MAP_NIL)                                                                        \
+            x = m->nodes[x].left;                                                                                     \
+        return x;                                                                                                     \
+    }                                                                                                                 \
+    uint32_t p = prefix##_parent(m, x);                                                                               \
+    while (p != RB_MAP_NIL && x == m->nodes[p].right)                                                                 \
+    {                                                                                                                 \
+        x = p;                                                                                                        \
+        p = prefix##_parent(m, p);                                                                                    \
+    }                                                                                                                 \
+    return p;                                                                                                         \
+}
+
+#endif